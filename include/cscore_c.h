@@ -53,7 +53,9 @@ enum CS_StatusValue {
   CS_READ_FAILED = -2004,
   CS_SOURCE_IS_DISCONNECTED = -2005,
   CS_EMPTY_VALUE = -2006,
-  CS_BAD_URL = -2007
+  CS_BAD_URL = -2007,
+  CS_TIMED_OUT = -2008,
+  CS_INVALID_PARAMETER = -2009
 };
 
 //
@@ -93,6 +95,39 @@ typedef struct CS_VideoMode {
   int fps;
 } CS_VideoMode;
 
+//
+// Frame metadata.  All times are in the same units as the frame time.
+//
+typedef struct CS_FrameMetadata {
+  uint64_t sequence;         // sequence number assigned by the source
+  uint64_t captureTime;      // capture time (the frame time)
+  uint64_t captureSequence;  // driver sequence number (USB cameras only)
+  uint64_t dequeueTime;      // time the frame was received from the device
+  uint64_t publishTime;      // time the frame was made available to sinks
+} CS_FrameMetadata;
+
+//
+// USB camera capture statistics, counted since the camera was created.
+// Times are in the same units as the frame time.  Intervals and lateness
+// are kept as totals so the averages over any period can be computed from
+// two snapshots.
+//
+typedef struct CS_UsbCameraStats {
+  uint64_t framesCaptured;   // good buffers dequeued from the driver
+  uint64_t framesDropped;    // dropped by the driver (sequence number gaps)
+  uint64_t framesSkipped;    // skipped in low latency mode
+  uint64_t errorBuffers;     // buffers returned with the error flag set
+  uint64_t requeueFailures;  // buffers that could not be requeued
+  uint64_t reconnects;       // reconnections after the device was lost
+  uint64_t intervalCount;    // intervals measured between captured frames
+  uint64_t intervalTotal;
+  uint64_t intervalMin;
+  uint64_t intervalMax;
+  uint64_t latenessCount;    // frames with a driver capture timestamp
+  uint64_t latenessTotal;    // time from capture to dequeue
+  uint64_t latenessMax;
+} CS_UsbCameraStats;
+
 //
 // Property kinds
 //
@@ -133,6 +168,15 @@ enum CS_SinkKind {
   CS_SINK_CV = 4
 };
 
+//
+// Sink frame delivery modes
+//
+enum CS_SinkDeliveryMode {
+  CS_SINK_DELIVER_LATEST = 0,     // only the most recent frame
+  CS_SINK_DELIVER_FIFO = 1,       // bounded queue of frames
+  CS_SINK_DELIVER_EVERY_NTH = 2   // most recent of every Nth frame
+};
+
 //
 // Listener event kinds
 //
@@ -151,7 +195,9 @@ enum CS_EventKind {
   CS_SINK_DESTROYED = 0x0800,
   CS_SINK_ENABLED = 0x1000,
   CS_SINK_DISABLED = 0x2000,
-  CS_NETWORK_INTERFACES_CHANGED = 0x4000
+  CS_NETWORK_INTERFACES_CHANGED = 0x4000,
+  CS_USB_CAMERAS_CHANGED = 0x8000,
+  CS_SOURCE_FRAMES_DROPPED = 0x10000
 };
 
 //
@@ -173,7 +219,7 @@ struct CS_Event {
   // Fields for CS_SOURCE_PROPERTY_* events
   CS_Property property;
   CS_PropertyKind propertyKind;
-  int value;
+  int value;  // also frames lost for CS_SOURCE_FRAMES_DROPPED
   const char* valueStr;
 };
 
@@ -185,6 +231,8 @@ enum CS_PropertyKind CS_GetPropertyKind(CS_Property property,
 char* CS_GetPropertyName(CS_Property property, CS_Status* status);
 int CS_GetProperty(CS_Property property, CS_Status* status);
 void CS_SetProperty(CS_Property property, int value, CS_Status* status);
+void CS_SetProperties(const CS_Property* properties, const int* values,
+                      int count, CS_Status* status);
 int CS_GetPropertyMin(CS_Property property, CS_Status* status);
 int CS_GetPropertyMax(CS_Property property, CS_Status* status);
 int CS_GetPropertyStep(CS_Property property, CS_Status* status);
@@ -216,6 +264,20 @@ CS_SourceKind CS_GetSourceKind(CS_Source source, CS_Status* status);
 char* CS_GetSourceName(CS_Source source, CS_Status* status);
 char* CS_GetSourceDescription(CS_Source source, CS_Status* status);
 uint64_t CS_GetSourceLastFrameTime(CS_Source source, CS_Status* status);
+uint64_t CS_GetSourceLastFrameSequence(CS_Source source, CS_Status* status);
+void CS_SetSourceFrameRingSize(CS_Source source, int size, CS_Status* status);
+int CS_GetSourceFrameRingSize(CS_Source source, CS_Status* status);
+void CS_SetSourceDeferLowPriority(CS_Source source, CS_Bool defer,
+                                  CS_Status* status);
+CS_Bool CS_GetSourceDeferLowPriority(CS_Source source, CS_Status* status);
+void CS_SetSourceMaxFPS(CS_Source source, double fps, CS_Status* status);
+double CS_GetSourceMaxFPS(CS_Source source, CS_Status* status);
+void CS_SetSourceDecimation(CS_Source source, int decimation,
+                            CS_Status* status);
+int CS_GetSourceDecimation(CS_Source source, CS_Status* status);
+void CS_SetSourceAutoVideoMode(CS_Source source, CS_Bool enabled,
+                               CS_Status* status);
+CS_Bool CS_GetSourceAutoVideoMode(CS_Source source, CS_Status* status);
 CS_Bool CS_IsSourceConnected(CS_Source source, CS_Status* status);
 CS_Property CS_GetSourceProperty(CS_Source source, const char* name,
                                  CS_Status* status);
@@ -260,6 +322,36 @@ void CS_SetCameraExposureManual(CS_Source source, int value, CS_Status* status);
 // UsbCamera Source Functions
 //
 char* CS_GetUsbCameraPath(CS_Source source, CS_Status* status);
+void CS_SetUsbCameraZeroCopy(CS_Source source, CS_Bool enabled,
+                             CS_Status* status);
+CS_Bool CS_GetUsbCameraZeroCopy(CS_Source source, CS_Status* status);
+void CS_SetUsbCameraUserBuffers(CS_Source source, CS_Bool enabled,
+                                CS_Status* status);
+CS_Bool CS_GetUsbCameraUserBuffers(CS_Source source, CS_Status* status);
+void CS_SetUsbCameraBufferCount(CS_Source source, int count,
+                                CS_Status* status);
+int CS_GetUsbCameraBufferCount(CS_Source source, CS_Status* status);
+void CS_SetUsbCameraAdaptiveBuffers(CS_Source source, CS_Bool enabled,
+                                    CS_Status* status);
+CS_Bool CS_GetUsbCameraAdaptiveBuffers(CS_Source source, CS_Status* status);
+void CS_SetUsbCameraLowLatency(CS_Source source, CS_Bool enabled,
+                               CS_Status* status);
+CS_Bool CS_GetUsbCameraLowLatency(CS_Source source, CS_Status* status);
+uint64_t CS_GetUsbCameraFramesSkipped(CS_Source source, CS_Status* status);
+void CS_GetUsbCameraStats(CS_Source source, CS_UsbCameraStats* stats,
+                          CS_Status* status);
+void CS_SetUsbCameraLinger(CS_Source source, double seconds,
+                           CS_Status* status);
+double CS_GetUsbCameraLinger(CS_Source source, CS_Status* status);
+void CS_SetUsbCameraStandbyFPS(CS_Source source, double fps,
+                               CS_Status* status);
+double CS_GetUsbCameraStandbyFPS(CS_Source source, CS_Status* status);
+void CS_SetUsbCameraCacheFile(const char* path);
+char* CS_GetUsbCameraCacheFile(void);
+void CS_SetUsbCameraReactorThreads(int numThreads);
+int CS_GetUsbCameraReactorThreads(void);
+CS_Bool CS_PlanUsbCameraModes(const CS_Source* sources, int count,
+                              CS_VideoMode* modes, CS_Status* status);
 
 //
 // HttpCamera Source Functions
@@ -307,6 +399,9 @@ void CS_SetSinkSource(CS_Sink sink, CS_Source source, CS_Status* status);
 CS_Property CS_GetSinkSourceProperty(CS_Sink sink, const char* name,
                                      CS_Status* status);
 CS_Source CS_GetSinkSource(CS_Sink sink, CS_Status* status);
+int CS_GetSinkEventFd(CS_Sink sink, CS_Status* status);
+void CS_SetSinkPriority(CS_Sink sink, int priority, CS_Status* status);
+int CS_GetSinkPriority(CS_Sink sink, CS_Status* status);
 CS_Sink CS_CopySink(CS_Sink sink, CS_Status* status);
 void CS_ReleaseSink(CS_Sink sink, CS_Status* status);
 
@@ -322,8 +417,29 @@ int CS_GetMjpegServerPort(CS_Sink sink, CS_Status* status);
 void CS_SetSinkDescription(CS_Sink sink, const char* description,
                            CS_Status* status);
 uint64_t CS_GrabSinkFrame(CS_Sink sink, struct CvMat* image, CS_Status* status);
+uint64_t CS_GrabSinkFrameTimeout(CS_Sink sink, struct CvMat* image,
+                                 double timeout, CS_Status* status);
+uint64_t CS_GrabSinkFrameMetadata(CS_Sink sink, struct CvMat* image,
+                                  double timeout, CS_FrameMetadata* metadata,
+                                  CS_Status* status);
+uint64_t CS_GrabSinkFrameAfter(CS_Sink sink, struct CvMat* image,
+                               uint64_t sequence, uint64_t* frameSequence,
+                               uint64_t* skipped, CS_Status* status);
+uint64_t CS_GrabSinkFrameNearTime(CS_Sink sink, struct CvMat* image,
+                                  uint64_t time, uint64_t* frameSequence,
+                                  CS_Status* status);
+uint64_t CS_GrabSinkFramesSync(const CS_Sink* sinks, int count,
+                               struct CvMat** images, double tolerance,
+                               double timeout, uint64_t* skew,
+                               uint64_t* dropped, CS_Status* status);
+int CS_WaitForAnySinkFrame(const CS_Sink* sinks, int count, double timeout,
+                           CS_Sink* ready, CS_Status* status);
 char* CS_GetSinkError(CS_Sink sink, CS_Status* status);
 void CS_SetSinkEnabled(CS_Sink sink, CS_Bool enabled, CS_Status* status);
+void CS_SetSinkDeliveryMode(CS_Sink sink, enum CS_SinkDeliveryMode mode,
+                            int param, CS_Status* status);
+uint64_t CS_GetSinkFramesDelivered(CS_Sink sink, CS_Status* status);
+uint64_t CS_GetSinkFramesDropped(CS_Sink sink, CS_Status* status);
 
 //
 // Listener Functions
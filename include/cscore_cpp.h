@@ -84,7 +84,9 @@ struct RawEvent {
     kSinkDestroyed = CS_SINK_DESTROYED,
     kSinkEnabled = CS_SINK_ENABLED,
     kSinkDisabled = CS_SINK_DISABLED,
-    kNetworkInterfacesChanged = CS_NETWORK_INTERFACES_CHANGED
+    kNetworkInterfacesChanged = CS_NETWORK_INTERFACES_CHANGED,
+    kUsbCamerasChanged = CS_USB_CAMERAS_CHANGED,
+    kSourceFramesDropped = CS_SOURCE_FRAMES_DROPPED
   };
 
   RawEvent() = default;
@@ -97,6 +99,9 @@ struct RawEvent {
     else
       sourceHandle = handle_;
   }
+  RawEvent(llvm::StringRef name_, CS_Source source_, RawEvent::Kind kind_,
+           int value_)
+      : kind{kind_}, sourceHandle{source_}, name{name_}, value{value_} {}
   RawEvent(llvm::StringRef name_, CS_Source source_, const VideoMode& mode_)
       : kind{kSourceVideoModeChanged},
         sourceHandle{source_},
@@ -128,7 +133,7 @@ struct RawEvent {
   // Fields for kSourceProperty* events
   CS_Property propertyHandle;
   CS_PropertyKind propertyKind;
-  int value;
+  int value;  // also frames lost for kSourceFramesDropped
   std::string valueStr;
 };
 
@@ -142,6 +147,8 @@ llvm::StringRef GetPropertyName(CS_Property property,
                                 CS_Status* status);
 int GetProperty(CS_Property property, CS_Status* status);
 void SetProperty(CS_Property property, int value, CS_Status* status);
+void SetProperties(llvm::ArrayRef<CS_Property> properties,
+                   llvm::ArrayRef<int> values, CS_Status* status);
 int GetPropertyMin(CS_Property property, CS_Status* status);
 int GetPropertyMax(CS_Property property, CS_Status* status);
 int GetPropertyStep(CS_Property property, CS_Status* status);
@@ -182,6 +189,17 @@ llvm::StringRef GetSourceDescription(CS_Source source,
                                      llvm::SmallVectorImpl<char>& buf,
                                      CS_Status* status);
 uint64_t GetSourceLastFrameTime(CS_Source source, CS_Status* status);
+uint64_t GetSourceLastFrameSequence(CS_Source source, CS_Status* status);
+void SetSourceFrameRingSize(CS_Source source, int size, CS_Status* status);
+int GetSourceFrameRingSize(CS_Source source, CS_Status* status);
+void SetSourceDeferLowPriority(CS_Source source, bool defer, CS_Status* status);
+bool GetSourceDeferLowPriority(CS_Source source, CS_Status* status);
+void SetSourceMaxFPS(CS_Source source, double fps, CS_Status* status);
+double GetSourceMaxFPS(CS_Source source, CS_Status* status);
+void SetSourceDecimation(CS_Source source, int decimation, CS_Status* status);
+int GetSourceDecimation(CS_Source source, CS_Status* status);
+void SetSourceAutoVideoMode(CS_Source source, bool enabled, CS_Status* status);
+bool GetSourceAutoVideoMode(CS_Source source, CS_Status* status);
 bool IsSourceConnected(CS_Source source, CS_Status* status);
 CS_Property GetSourceProperty(CS_Source source, llvm::StringRef name,
                               CS_Status* status);
@@ -220,6 +238,31 @@ void SetCameraExposureManual(CS_Source source, int value, CS_Status* status);
 // UsbCamera Source Functions
 //
 std::string GetUsbCameraPath(CS_Source source, CS_Status* status);
+void SetUsbCameraZeroCopy(CS_Source source, bool enabled, CS_Status* status);
+bool GetUsbCameraZeroCopy(CS_Source source, CS_Status* status);
+void SetUsbCameraUserBuffers(CS_Source source, bool enabled,
+                             CS_Status* status);
+bool GetUsbCameraUserBuffers(CS_Source source, CS_Status* status);
+void SetUsbCameraBufferCount(CS_Source source, int count, CS_Status* status);
+int GetUsbCameraBufferCount(CS_Source source, CS_Status* status);
+void SetUsbCameraAdaptiveBuffers(CS_Source source, bool enabled,
+                                 CS_Status* status);
+bool GetUsbCameraAdaptiveBuffers(CS_Source source, CS_Status* status);
+void SetUsbCameraLowLatency(CS_Source source, bool enabled, CS_Status* status);
+bool GetUsbCameraLowLatency(CS_Source source, CS_Status* status);
+uint64_t GetUsbCameraFramesSkipped(CS_Source source, CS_Status* status);
+void GetUsbCameraStats(CS_Source source, CS_UsbCameraStats* stats,
+                       CS_Status* status);
+void SetUsbCameraLinger(CS_Source source, double seconds, CS_Status* status);
+double GetUsbCameraLinger(CS_Source source, CS_Status* status);
+void SetUsbCameraStandbyFPS(CS_Source source, double fps, CS_Status* status);
+double GetUsbCameraStandbyFPS(CS_Source source, CS_Status* status);
+void SetUsbCameraCacheFile(llvm::StringRef path);
+std::string GetUsbCameraCacheFile();
+void SetUsbCameraReactorThreads(int numThreads);
+int GetUsbCameraReactorThreads();
+bool PlanUsbCameraModes(llvm::ArrayRef<CS_Source> sources,
+                        std::vector<VideoMode>* modes, CS_Status* status);
 
 //
 // HttpCamera Source Functions
@@ -271,6 +314,9 @@ void SetSinkSource(CS_Sink sink, CS_Source source, CS_Status* status);
 CS_Property GetSinkSourceProperty(CS_Sink sink, llvm::StringRef name,
                                   CS_Status* status);
 CS_Source GetSinkSource(CS_Sink sink, CS_Status* status);
+int GetSinkEventFd(CS_Sink sink, CS_Status* status);
+void SetSinkPriority(CS_Sink sink, int priority, CS_Status* status);
+int GetSinkPriority(CS_Sink sink, CS_Status* status);
 CS_Sink CopySink(CS_Sink sink, CS_Status* status);
 void ReleaseSink(CS_Sink sink, CS_Status* status);
 
@@ -286,10 +332,31 @@ int GetMjpegServerPort(CS_Sink sink, CS_Status* status);
 void SetSinkDescription(CS_Sink sink, llvm::StringRef description,
                         CS_Status* status);
 uint64_t GrabSinkFrame(CS_Sink sink, cv::Mat& image, CS_Status* status);
+uint64_t GrabSinkFrameTimeout(CS_Sink sink, cv::Mat& image, double timeout,
+                              CS_Status* status);
+uint64_t GrabSinkFrameMetadata(CS_Sink sink, cv::Mat& image, double timeout,
+                               CS_FrameMetadata* metadata, CS_Status* status);
+uint64_t GrabSinkFrameAfter(CS_Sink sink, cv::Mat& image, uint64_t sequence,
+                            uint64_t* frameSequence, uint64_t* skipped,
+                            CS_Status* status);
+uint64_t GrabSinkFrameNearTime(CS_Sink sink, cv::Mat& image, uint64_t time,
+                               uint64_t* frameSequence, CS_Status* status);
+uint64_t GrabSinkFramesSync(llvm::ArrayRef<CS_Sink> sinks,
+                            llvm::MutableArrayRef<cv::Mat> images,
+                            double tolerance, double timeout, uint64_t* skew,
+                            uint64_t* dropped, CS_Status* status);
+llvm::ArrayRef<CS_Sink> WaitForAnySinkFrame(llvm::ArrayRef<CS_Sink> sinks,
+                                            double timeout,
+                                            llvm::SmallVectorImpl<CS_Sink>& vec,
+                                            CS_Status* status);
 std::string GetSinkError(CS_Sink sink, CS_Status* status);
 llvm::StringRef GetSinkError(CS_Sink sink, llvm::SmallVectorImpl<char>& buf,
                              CS_Status* status);
 void SetSinkEnabled(CS_Sink sink, bool enabled, CS_Status* status);
+void SetSinkDeliveryMode(CS_Sink sink, CS_SinkDeliveryMode mode, int param,
+                         CS_Status* status);
+uint64_t GetSinkFramesDelivered(CS_Sink sink, CS_Status* status);
+uint64_t GetSinkFramesDropped(CS_Sink sink, CS_Status* status);
 
 //
 // Listener Functions
@@ -331,6 +398,22 @@ std::vector<std::string> GetNetworkInterfaces();
 // C functions taking a cv::Mat* for specific interop implementations
 extern "C" {
 uint64_t CS_GrabSinkFrameCpp(CS_Sink sink, cv::Mat* image, CS_Status* status);
+uint64_t CS_GrabSinkFrameTimeoutCpp(CS_Sink sink, cv::Mat* image,
+                                    double timeout, CS_Status* status);
+uint64_t CS_GrabSinkFrameMetadataCpp(CS_Sink sink, cv::Mat* image,
+                                     double timeout,
+                                     CS_FrameMetadata* metadata,
+                                     CS_Status* status);
+uint64_t CS_GrabSinkFrameAfterCpp(CS_Sink sink, cv::Mat* image,
+                                  uint64_t sequence, uint64_t* frameSequence,
+                                  uint64_t* skipped, CS_Status* status);
+uint64_t CS_GrabSinkFrameNearTimeCpp(CS_Sink sink, cv::Mat* image,
+                                     uint64_t time, uint64_t* frameSequence,
+                                     CS_Status* status);
+uint64_t CS_GrabSinkFramesSyncCpp(const CS_Sink* sinks, int count,
+                                  cv::Mat* images, double tolerance,
+                                  double timeout, uint64_t* skew,
+                                  uint64_t* dropped, CS_Status* status);
 void CS_PutSourceFrameCpp(CS_Source source, cv::Mat* image, CS_Status* status);
 }
 
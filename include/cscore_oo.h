@@ -121,6 +121,57 @@ class VideoSource {
   /// Get the last time a frame was captured.
   uint64_t GetLastFrameTime() const;
 
+  /// Get the sequence number of the last frame captured.  Sequence numbers
+  /// start at 1 and increase by one for every frame.
+  uint64_t GetLastFrameSequence() const;
+
+  /// Set the number of recent frames retained by the source.  Retaining
+  /// more frames lets slow consumers catch up (see CvSink::GrabFrameAfter())
+  /// and lets frames be matched by capture time (see
+  /// CvSink::GrabFrameNearTime()).  The minimum (and default) is 1.
+  /// @param size Number of frames
+  void SetFrameRingSize(int size);
+
+  /// Get the number of recent frames retained by the source.
+  int GetFrameRingSize() const;
+
+  /// Set whether lower priority sinks are held off (for a bounded time)
+  /// until the highest priority sinks have taken each new frame.
+  /// See VideoSink::SetPriority().
+  /// @param defer True to defer lower priority sinks
+  void SetDeferLowPriority(bool defer);
+
+  /// Get whether lower priority sinks are deferred.
+  bool GetDeferLowPriority() const;
+
+  /// Limit the rate at which the source publishes frames.  Frames over the
+  /// limit are dropped before any sink sees (or converts) them.  Useful for
+  /// cameras that can't be set to the desired FPS.
+  /// @param fps Maximum frames per second (0 for no limit)
+  void SetMaxFPS(double fps);
+
+  /// Get the frame rate limit (0 if none).
+  double GetMaxFPS() const;
+
+  /// Publish only every Nth frame from the camera.
+  /// @param decimation N (1 to publish every frame)
+  void SetDecimation(int decimation);
+
+  /// Get the decimation factor.
+  int GetDecimation() const;
+
+  /// Enable or disable automatic video mode selection.  While enabled, the
+  /// source switches to the cheapest video mode that still satisfies the
+  /// largest image requested by its enabled sinks (e.g. MJPEG stream
+  /// resolution), never exceeding the mode in effect when auto mode was
+  /// enabled.  Set the desired maximum mode first, and disable auto mode
+  /// before setting a mode explicitly.
+  /// @param enabled True to enable auto mode
+  void SetAutoVideoMode(bool enabled);
+
+  /// Get whether automatic video mode selection is enabled.
+  bool GetAutoVideoMode() const;
+
   /// Is the source currently connected to whatever is providing the images?
   bool IsConnected() const;
 
@@ -133,6 +184,13 @@ class VideoSource {
   /// Enumerate all properties of this source.
   std::vector<VideoProperty> EnumerateProperties() const;
 
+  /// Set several integer properties of this source at once.  USB cameras
+  /// apply them to the device in a single batched write where possible.
+  /// @param properties Properties to set
+  /// @param values Values, one per property
+  void SetProperties(llvm::ArrayRef<VideoProperty> properties,
+                     llvm::ArrayRef<int> values);
+
   /// Get the current video mode.
   VideoMode GetVideoMode() const;
 
@@ -251,8 +309,121 @@ class UsbCamera : public VideoCamera {
   /// @return Vector of USB camera information (one for each camera)
   static std::vector<UsbCameraInfo> EnumerateUsbCameras();
 
+  /// Set the number of shared capture threads.  By default (0) each USB
+  /// camera runs its own thread.  When nonzero, cameras created afterwards
+  /// are instead serviced by this many shared threads, which scales better
+  /// with many cameras.
+  /// @param numThreads Number of shared threads (0 to disable)
+  static void SetReactorThreads(int numThreads);
+
+  /// Get the number of shared capture threads (0 if disabled).
+  static int GetReactorThreads();
+
+  /// Set the capability cache file.  When set, the video modes and controls
+  /// of each camera are saved there and reused the next time the camera
+  /// connects, skipping enumeration; they are checked against the device in
+  /// the background after the first frame.  Set before creating cameras.
+  /// @param path Cache file path (empty to disable, the default)
+  static void SetCacheFile(llvm::StringRef path);
+
+  /// Get the capability cache file (empty if disabled).
+  static std::string GetCacheFile();
+
+  /// Plan video modes for several cameras so the USB bandwidth they need
+  /// fits the buses they share.  Starting from each camera's current mode,
+  /// the cameras using the most bandwidth fall back to MJPEG at the same
+  /// resolution, then to lower frame rates.  Cameras must have connected
+  /// so their modes are known.
+  /// @param cameras Cameras to plan for
+  /// @param modes Planned mode for each camera (apply with SetVideoMode)
+  /// @param status Set to CS_SOURCE_IS_DISCONNECTED if a camera's mode is
+  ///        not known yet
+  /// @return False if a bus is oversubscribed even after falling back, or
+  ///         on error (modes is then empty)
+  static bool PlanVideoModes(llvm::ArrayRef<UsbCamera> cameras,
+                             std::vector<VideoMode>* modes,
+                             CS_Status* status);
+
   /// Get the path to the device.
   std::string GetPath() const;
+
+  /// Enable or disable zero-copy capture.  When enabled, frames reference
+  /// the driver's buffers directly instead of being copied; a buffer is
+  /// returned to the driver when the last frame using it is released.
+  /// Sinks that hold frames for a long time (e.g. FIFO delivery) may cause
+  /// frames to be copied anyway so the camera does not run out of buffers.
+  /// Changing the video mode while a sink still holds a zero-copy frame
+  /// reconnects to the camera rather than switching in place.
+  /// @param enabled True to enable zero-copy capture (default is disabled)
+  void SetZeroCopy(bool enabled);
+
+  /// Get whether zero-copy capture is enabled.
+  bool GetZeroCopy() const;
+
+  /// Enable or disable user pointer capture.  When enabled (and supported
+  /// by the driver), the camera captures directly into pooled image buffers
+  /// that are published without copying.  Changing this reconnects to the
+  /// camera.
+  /// @param enabled True to enable user pointer capture (default is disabled)
+  void SetUserBuffers(bool enabled);
+
+  /// Get whether user pointer capture is enabled.
+  bool GetUserBuffers() const;
+
+  /// Set the number of buffers requested from the driver (also available as
+  /// the "buffer_count" property).  More buffers tolerate a busy CPU at high
+  /// frame rates; fewer keep frames fresher.  Changing this reconnects to
+  /// the camera.
+  /// @param count Number of buffers (2 to 32, default 4)
+  void SetBufferCount(int count);
+
+  /// Get the number of buffers currently allocated by the driver.
+  int GetBufferCount() const;
+
+  /// Enable or disable adaptive buffer counts.  When enabled, buffers are
+  /// added while the driver drops frames and removed (down to the count set
+  /// with SetBufferCount()) once capture keeps up.
+  /// @param enabled True to enable adaptation (default is disabled)
+  void SetAdaptiveBuffers(bool enabled);
+
+  /// Get whether adaptive buffer counts are enabled.
+  bool GetAdaptiveBuffers() const;
+
+  /// Enable or disable low latency mode.  When the camera thread falls
+  /// behind and several frames are waiting, only the newest is published;
+  /// the older ones are skipped.
+  /// @param enabled True to enable low latency mode (default is disabled)
+  void SetLowLatency(bool enabled);
+
+  /// Get whether low latency mode is enabled.
+  bool GetLowLatency() const;
+
+  /// Get the number of frames skipped by low latency mode.
+  uint64_t GetFramesSkipped() const;
+
+  /// Get capture statistics: frames captured, dropped by the driver, or
+  /// returned in error, requeue failures, reconnects, and frame interval
+  /// and dequeue lateness totals.  CS_SOURCE_FRAMES_DROPPED events report
+  /// lost frames as they happen.
+  CS_UsbCameraStats GetStats() const;
+
+  /// Set how long to keep streaming after the last sink is disabled.  A
+  /// sink enabled again within this time gets frames immediately rather
+  /// than waiting for the camera to restart.
+  /// @param seconds Linger time in seconds (default 0)
+  void SetLinger(double seconds);
+
+  /// Get the linger time in seconds.
+  double GetLinger() const;
+
+  /// Set the standby frame rate.  If nonzero, once the linger time expires
+  /// the camera keeps streaming but frames are only published at this rate,
+  /// so newly enabled sinks get a recent frame immediately.
+  /// @param fps Standby frame rate (default 0, which stops streaming)
+  void SetStandbyFPS(double fps);
+
+  /// Get the standby frame rate.
+  double GetStandbyFPS() const;
 };
 
 /// A source that represents a MJPEG-over-HTTP (IP) camera.
@@ -470,6 +641,22 @@ class VideoSink {
   /// @return Connected source (empty if none connected).
   VideoSource GetSource() const;
 
+  /// Get an event file descriptor that becomes readable each time the
+  /// connected source has a new frame, for use with poll/select/epoll.
+  /// Read from it (8 bytes) to reset it.  The sink must be enabled for the
+  /// source to produce frames.  The descriptor is owned by the sink and
+  /// closed when the sink is destroyed.
+  /// @return File descriptor, or -1 if not supported on this platform.
+  int GetEventFd() const;
+
+  /// Set the sink priority.  When the source has a new frame, sinks with
+  /// higher priority are woken first.  The default priority is 0.
+  /// @param priority Priority
+  void SetPriority(int priority);
+
+  /// Get the sink priority.
+  int GetPriority() const;
+
   /// Get a property of the associated source.
   /// @param name Property name
   /// @return Property (kind Property::kNone if no property with
@@ -521,6 +708,12 @@ class MjpegServer : public VideoSink {
 /// A sink for user code to accept video frames as OpenCV images.
 class CvSink : public VideoSink {
  public:
+  enum DeliveryMode {
+    kLatest = CS_SINK_DELIVER_LATEST,
+    kFifo = CS_SINK_DELIVER_FIFO,
+    kEveryNth = CS_SINK_DELIVER_EVERY_NTH
+  };
+
   CvSink() = default;
 
   /// Create a sink for accepting OpenCV images.
@@ -549,6 +742,76 @@ class CvSink : public VideoSink {
   ///         message);
   uint64_t GrabFrame(cv::Mat& image) const;
 
+  /// Wait for the next frame and get the image.  Times out (returning 0)
+  /// after timeout seconds.  Returns immediately if a frame newer than the
+  /// last one grabbed by this sink is already available, so a timeout of 0
+  /// can be used after GetEventFd() becomes readable.
+  /// The provided image will have three 8-bit channels stored in BGR order.
+  /// @return Frame time, or 0 on error or timeout (call GetError() to obtain
+  ///         the error message; GetLastStatus() is CS_TIMED_OUT on timeout)
+  uint64_t GrabFrame(cv::Mat& image, double timeout) const;
+
+  /// Wait for the next frame and get the image and its capture metadata.
+  /// For USB cameras, the frame time is the driver's capture timestamp, and
+  /// the metadata also reports when the frame was dequeued and published.
+  /// @param metadata Set to the frame metadata
+  /// @param timeout Timeout in seconds (negative to wait forever)
+  /// @return Frame time, or 0 on error or timeout
+  uint64_t GrabFrame(cv::Mat& image, CS_FrameMetadata* metadata,
+                     double timeout = -1) const;
+
+  /// Wait for the frame following the given sequence number and get the
+  /// image.  If the source has already dropped that frame from its frame
+  /// ring, the oldest retained frame is returned instead.
+  /// @param sequence Sequence number of the last frame processed (0 to wait
+  ///        for the next frame)
+  /// @param frameSequence Set to the sequence number of the returned frame
+  /// @param skipped Set to the number of frames lost between sequence and
+  ///        the returned frame
+  /// @return Frame time, or 0 on error
+  uint64_t GrabFrameAfter(cv::Mat& image, uint64_t sequence,
+                          uint64_t* frameSequence, uint64_t* skipped) const;
+
+  /// Get the image of the retained frame captured nearest the given time.
+  /// Does not wait for a new frame.
+  /// @param time Time (in the same units as the frame time)
+  /// @param frameSequence Set to the sequence number of the returned frame
+  /// @return Frame time, or 0 if no frame is available
+  uint64_t GrabFrameNearTime(cv::Mat& image, uint64_t time,
+                             uint64_t* frameSequence = nullptr) const;
+
+  /// Wait until every sink's source has a frame within tolerance of the
+  /// others and get the matched set of images.  Frames are matched against
+  /// each source's frame ring, so sources with unsynchronized capture should
+  /// have a frame ring size of at least 2 (see VideoSource::SetFrameRingSize).
+  /// @param sinks Sinks to grab from
+  /// @param images Images (one per sink)
+  /// @param tolerance Maximum difference between frame times, in seconds
+  /// @param timeout Timeout in seconds
+  /// @param skew Set to the difference between the earliest and latest frame
+  ///        times of the matched set (in frame time units)
+  /// @param dropped Set to the number of frames skipped (never matched) since
+  ///        the previous grab, summed across sinks
+  /// @param status Set to CS_TIMED_OUT on timeout
+  /// @return Time of the earliest frame in the set, or 0 on error or timeout
+  static uint64_t GrabFramesSync(llvm::ArrayRef<CvSink> sinks,
+                                 llvm::MutableArrayRef<cv::Mat> images,
+                                 double tolerance, double timeout,
+                                 uint64_t* skew, uint64_t* dropped,
+                                 CS_Status* status);
+
+  /// Wait until at least one of the sinks has a new frame, so that one
+  /// thread can service several cameras.  GrabFrame() on a returned sink
+  /// returns that frame without waiting (unless its source is changed in
+  /// the meantime).  A sink's source may be changed during the wait; the
+  /// new source is picked up within 100 ms.
+  /// @param sinks Sinks to wait on
+  /// @param timeout Timeout in seconds (negative to wait forever)
+  /// @return Indices (into sinks) of the sinks with new frames; empty on
+  ///         timeout
+  static std::vector<int> WaitForAnyFrame(llvm::ArrayRef<CvSink> sinks,
+                                          double timeout);
+
   /// Get error string.  Call this if WaitForFrame() returns 0 to determine
   /// what the error is.
   std::string GetError() const;
@@ -558,6 +821,20 @@ class CvSink : public VideoSink {
   /// be called and WaitForFrame() to not return.  This can be used to save
   /// processor resources when frames are not needed.
   void SetEnabled(bool enabled);
+
+  /// Set how frames are delivered to GrabFrame().
+  /// kLatest (the default) returns only the most recent frame.  kFifo queues
+  /// up to param frames, so every frame is seen unless the queue overflows.
+  /// kEveryNth returns the most recent of every param frames.
+  /// @param mode Delivery mode
+  /// @param param FIFO depth (kFifo) or N (kEveryNth); ignored for kLatest
+  void SetDeliveryMode(DeliveryMode mode, int param = 1);
+
+  /// Get the number of frames returned by GrabFrame().
+  uint64_t GetFramesDelivered() const;
+
+  /// Get the number of frames dropped (never returned by GrabFrame()).
+  uint64_t GetFramesDropped() const;
 };
 
 /// An event generated by the library and provided to event listeners.
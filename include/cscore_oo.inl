@@ -116,6 +116,61 @@ inline uint64_t VideoSource::GetLastFrameTime() const {
   return GetSourceLastFrameTime(m_handle, &m_status);
 }
 
+inline uint64_t VideoSource::GetLastFrameSequence() const {
+  m_status = 0;
+  return GetSourceLastFrameSequence(m_handle, &m_status);
+}
+
+inline void VideoSource::SetFrameRingSize(int size) {
+  m_status = 0;
+  SetSourceFrameRingSize(m_handle, size, &m_status);
+}
+
+inline int VideoSource::GetFrameRingSize() const {
+  m_status = 0;
+  return GetSourceFrameRingSize(m_handle, &m_status);
+}
+
+inline void VideoSource::SetDeferLowPriority(bool defer) {
+  m_status = 0;
+  SetSourceDeferLowPriority(m_handle, defer, &m_status);
+}
+
+inline bool VideoSource::GetDeferLowPriority() const {
+  m_status = 0;
+  return GetSourceDeferLowPriority(m_handle, &m_status);
+}
+
+inline void VideoSource::SetMaxFPS(double fps) {
+  m_status = 0;
+  SetSourceMaxFPS(m_handle, fps, &m_status);
+}
+
+inline double VideoSource::GetMaxFPS() const {
+  m_status = 0;
+  return GetSourceMaxFPS(m_handle, &m_status);
+}
+
+inline void VideoSource::SetDecimation(int decimation) {
+  m_status = 0;
+  SetSourceDecimation(m_handle, decimation, &m_status);
+}
+
+inline int VideoSource::GetDecimation() const {
+  m_status = 0;
+  return GetSourceDecimation(m_handle, &m_status);
+}
+
+inline void VideoSource::SetAutoVideoMode(bool enabled) {
+  m_status = 0;
+  SetSourceAutoVideoMode(m_handle, enabled, &m_status);
+}
+
+inline bool VideoSource::GetAutoVideoMode() const {
+  m_status = 0;
+  return GetSourceAutoVideoMode(m_handle, &m_status);
+}
+
 inline bool VideoSource::IsConnected() const {
   m_status = 0;
   return IsSourceConnected(m_handle, &m_status);
@@ -216,11 +271,117 @@ inline std::vector<UsbCameraInfo> UsbCamera::EnumerateUsbCameras() {
   return ::cs::EnumerateUsbCameras(&status);
 }
 
+inline void UsbCamera::SetReactorThreads(int numThreads) {
+  SetUsbCameraReactorThreads(numThreads);
+}
+
+inline int UsbCamera::GetReactorThreads() {
+  return GetUsbCameraReactorThreads();
+}
+
+inline void UsbCamera::SetCacheFile(llvm::StringRef path) {
+  SetUsbCameraCacheFile(path);
+}
+
+inline std::string UsbCamera::GetCacheFile() {
+  return GetUsbCameraCacheFile();
+}
+
+inline bool UsbCamera::PlanVideoModes(llvm::ArrayRef<UsbCamera> cameras,
+                                      std::vector<VideoMode>* modes,
+                                      CS_Status* status) {
+  std::vector<CS_Source> sources;
+  for (const auto& camera : cameras) sources.push_back(camera.GetHandle());
+  return PlanUsbCameraModes(sources, modes, status);
+}
+
 inline std::string UsbCamera::GetPath() const {
   m_status = 0;
   return ::cs::GetUsbCameraPath(m_handle, &m_status);
 }
 
+inline void UsbCamera::SetZeroCopy(bool enabled) {
+  m_status = 0;
+  SetUsbCameraZeroCopy(m_handle, enabled, &m_status);
+}
+
+inline bool UsbCamera::GetZeroCopy() const {
+  m_status = 0;
+  return GetUsbCameraZeroCopy(m_handle, &m_status);
+}
+
+inline void UsbCamera::SetUserBuffers(bool enabled) {
+  m_status = 0;
+  SetUsbCameraUserBuffers(m_handle, enabled, &m_status);
+}
+
+inline bool UsbCamera::GetUserBuffers() const {
+  m_status = 0;
+  return GetUsbCameraUserBuffers(m_handle, &m_status);
+}
+
+inline void UsbCamera::SetBufferCount(int count) {
+  m_status = 0;
+  SetUsbCameraBufferCount(m_handle, count, &m_status);
+}
+
+inline int UsbCamera::GetBufferCount() const {
+  m_status = 0;
+  return GetUsbCameraBufferCount(m_handle, &m_status);
+}
+
+inline void UsbCamera::SetAdaptiveBuffers(bool enabled) {
+  m_status = 0;
+  SetUsbCameraAdaptiveBuffers(m_handle, enabled, &m_status);
+}
+
+inline bool UsbCamera::GetAdaptiveBuffers() const {
+  m_status = 0;
+  return GetUsbCameraAdaptiveBuffers(m_handle, &m_status);
+}
+
+inline void UsbCamera::SetLowLatency(bool enabled) {
+  m_status = 0;
+  SetUsbCameraLowLatency(m_handle, enabled, &m_status);
+}
+
+inline bool UsbCamera::GetLowLatency() const {
+  m_status = 0;
+  return GetUsbCameraLowLatency(m_handle, &m_status);
+}
+
+inline uint64_t UsbCamera::GetFramesSkipped() const {
+  m_status = 0;
+  return GetUsbCameraFramesSkipped(m_handle, &m_status);
+}
+
+inline CS_UsbCameraStats UsbCamera::GetStats() const {
+  CS_UsbCameraStats stats;
+  m_status = 0;
+  GetUsbCameraStats(m_handle, &stats, &m_status);
+  return stats;
+}
+
+inline void UsbCamera::SetLinger(double seconds) {
+  m_status = 0;
+  SetUsbCameraLinger(m_handle, seconds, &m_status);
+}
+
+inline double UsbCamera::GetLinger() const {
+  m_status = 0;
+  return GetUsbCameraLinger(m_handle, &m_status);
+}
+
+inline void UsbCamera::SetStandbyFPS(double fps) {
+  m_status = 0;
+  SetUsbCameraStandbyFPS(m_handle, fps, &m_status);
+}
+
+inline double UsbCamera::GetStandbyFPS() const {
+  m_status = 0;
+  return GetUsbCameraStandbyFPS(m_handle, &m_status);
+}
+
 inline HttpCamera::HttpCamera(llvm::StringRef name, llvm::StringRef url,
                               HttpCameraKind kind) {
   m_handle = CreateHttpCamera(
@@ -430,6 +591,21 @@ inline VideoSource VideoSink::GetSource() const {
   return VideoSource{GetSinkSource(m_handle, &m_status)};
 }
 
+inline int VideoSink::GetEventFd() const {
+  m_status = 0;
+  return GetSinkEventFd(m_handle, &m_status);
+}
+
+inline void VideoSink::SetPriority(int priority) {
+  m_status = 0;
+  SetSinkPriority(m_handle, priority, &m_status);
+}
+
+inline int VideoSink::GetPriority() const {
+  m_status = 0;
+  return GetSinkPriority(m_handle, &m_status);
+}
+
 inline VideoProperty VideoSink::GetSourceProperty(llvm::StringRef name) {
   m_status = 0;
   return VideoProperty{GetSinkSourceProperty(m_handle, name, &m_status)};
@@ -469,6 +645,32 @@ inline uint64_t CvSink::GrabFrame(cv::Mat& image) const {
   return GrabSinkFrame(m_handle, image, &m_status);
 }
 
+inline uint64_t CvSink::GrabFrame(cv::Mat& image, double timeout) const {
+  m_status = 0;
+  return GrabSinkFrameTimeout(m_handle, image, timeout, &m_status);
+}
+
+inline uint64_t CvSink::GrabFrame(cv::Mat& image, CS_FrameMetadata* metadata,
+                                  double timeout) const {
+  m_status = 0;
+  return GrabSinkFrameMetadata(m_handle, image, timeout, metadata, &m_status);
+}
+
+inline uint64_t CvSink::GrabFrameAfter(cv::Mat& image, uint64_t sequence,
+                                       uint64_t* frameSequence,
+                                       uint64_t* skipped) const {
+  m_status = 0;
+  return GrabSinkFrameAfter(m_handle, image, sequence, frameSequence, skipped,
+                            &m_status);
+}
+
+inline uint64_t CvSink::GrabFrameNearTime(cv::Mat& image, uint64_t time,
+                                          uint64_t* frameSequence) const {
+  m_status = 0;
+  return GrabSinkFrameNearTime(m_handle, image, time, frameSequence,
+                               &m_status);
+}
+
 inline std::string CvSink::GetError() const {
   m_status = 0;
   return GetSinkError(m_handle, &m_status);
@@ -479,6 +681,22 @@ inline void CvSink::SetEnabled(bool enabled) {
   SetSinkEnabled(m_handle, enabled, &m_status);
 }
 
+inline void CvSink::SetDeliveryMode(DeliveryMode mode, int param) {
+  m_status = 0;
+  SetSinkDeliveryMode(m_handle, static_cast<CS_SinkDeliveryMode>(mode), param,
+                      &m_status);
+}
+
+inline uint64_t CvSink::GetFramesDelivered() const {
+  m_status = 0;
+  return GetSinkFramesDelivered(m_handle, &m_status);
+}
+
+inline uint64_t CvSink::GetFramesDropped() const {
+  m_status = 0;
+  return GetSinkFramesDropped(m_handle, &m_status);
+}
+
 inline VideoSource VideoEvent::GetSource() const {
   CS_Status status = 0;
   return VideoSource{sourceHandle == 0 ? 0 : CopySource(sourceHandle, &status)};
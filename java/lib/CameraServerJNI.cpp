@@ -163,6 +163,12 @@ static void ReportError(JNIEnv *env, CS_Status status) {
     case CS_BAD_URL:
       msg = "bad URL";
       break;
+    case CS_TIMED_OUT:
+      msg = "timed out";
+      break;
+    case CS_INVALID_PARAMETER:
+      msg = "invalid parameter";
+      break;
     default: {
       llvm::raw_svector_ostream oss{msg};
       oss << "unknown error code=" << status;
@@ -1261,6 +1267,23 @@ JNIEXPORT jlong JNICALL Java_edu_wpi_cscore_CameraServerJNI_grabSinkFrame
   return rv;
 }
 
+/*
+ * Class:     edu_wpi_cscore_CameraServerJNI
+ * Method:    grabSinkFrameTimeout
+ * Signature: (IJD)J
+ */
+JNIEXPORT jlong JNICALL Java_edu_wpi_cscore_CameraServerJNI_grabSinkFrameTimeout
+  (JNIEnv *env, jclass, jint sink, jlong imageNativeObj, jdouble timeout)
+{
+  cv::Mat& image = *((cv::Mat*)imageNativeObj);
+  CS_Status status = 0;
+  auto rv = cs::GrabSinkFrameTimeout(sink, image, timeout, &status);
+  // A timeout is an expected outcome, not an exception; it is reported via
+  // the 0 return value and getSinkError().
+  if (status != CS_TIMED_OUT) CheckStatus(env, status);
+  return rv;
+}
+
 /*
  * Class:     edu_wpi_cscore_CameraServerJNI
  * Method:    getSinkError
@@ -1289,6 +1312,70 @@ JNIEXPORT void JNICALL Java_edu_wpi_cscore_CameraServerJNI_setSinkEnabled
   CheckStatus(env, status);
 }
 
+/*
+ * Class:     edu_wpi_cscore_CameraServerJNI
+ * Method:    setSinkDeliveryMode
+ * Signature: (III)V
+ */
+JNIEXPORT void JNICALL Java_edu_wpi_cscore_CameraServerJNI_setSinkDeliveryMode
+  (JNIEnv *env, jclass, jint sink, jint mode, jint param)
+{
+  CS_Status status = 0;
+  cs::SetSinkDeliveryMode(sink, static_cast<CS_SinkDeliveryMode>(mode), param,
+                          &status);
+  CheckStatus(env, status);
+}
+
+/*
+ * Class:     edu_wpi_cscore_CameraServerJNI
+ * Method:    getSinkFramesDelivered
+ * Signature: (I)J
+ */
+JNIEXPORT jlong JNICALL Java_edu_wpi_cscore_CameraServerJNI_getSinkFramesDelivered
+  (JNIEnv *env, jclass, jint sink)
+{
+  CS_Status status = 0;
+  auto val = cs::GetSinkFramesDelivered(sink, &status);
+  CheckStatus(env, status);
+  return val;
+}
+
+/*
+ * Class:     edu_wpi_cscore_CameraServerJNI
+ * Method:    getSinkFramesDropped
+ * Signature: (I)J
+ */
+JNIEXPORT jlong JNICALL Java_edu_wpi_cscore_CameraServerJNI_getSinkFramesDropped
+  (JNIEnv *env, jclass, jint sink)
+{
+  CS_Status status = 0;
+  auto val = cs::GetSinkFramesDropped(sink, &status);
+  CheckStatus(env, status);
+  return val;
+}
+
+/*
+ * Class:     edu_wpi_cscore_CameraServerJNI
+ * Method:    waitForAnySinkFrame
+ * Signature: ([ID)[I
+ */
+JNIEXPORT jintArray JNICALL Java_edu_wpi_cscore_CameraServerJNI_waitForAnySinkFrame
+  (JNIEnv *env, jclass, jintArray sinks, jdouble timeout)
+{
+  if (!sinks) {
+    nullPointerEx.Throw(env, "sinks cannot be null");
+    return nullptr;
+  }
+  size_t len = env->GetArrayLength(sinks);
+  llvm::SmallVector<CS_Sink, 8> vec(len);
+  env->GetIntArrayRegion(sinks, 0, len, vec.data());
+  CS_Status status = 0;
+  llvm::SmallVector<CS_Sink, 8> buf;
+  auto arr = cs::WaitForAnySinkFrame(vec, timeout, buf, &status);
+  if (status != CS_TIMED_OUT && !CheckStatus(env, status)) return nullptr;
+  return MakeJIntArray(env, arr);
+}
+
 /*
  * Class:     edu_wpi_cscore_CameraServerJNI
  * Method:    addListener
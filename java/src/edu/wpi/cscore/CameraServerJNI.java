@@ -193,8 +193,13 @@ public class CameraServerJNI {
   //
   public static native void setSinkDescription(int sink, String description);
   public static native long grabSinkFrame(int sink, long imageNativeObj);
+  public static native long grabSinkFrameTimeout(int sink, long imageNativeObj, double timeout);
   public static native String getSinkError(int sink);
   public static native void setSinkEnabled(int sink, boolean enabled);
+  public static native void setSinkDeliveryMode(int sink, int mode, int param);
+  public static native long getSinkFramesDelivered(int sink);
+  public static native long getSinkFramesDropped(int sink);
+  public static native int[] waitForAnySinkFrame(int[] sinks, double timeout);
 
   //
   // Listener Functions
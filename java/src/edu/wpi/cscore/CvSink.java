@@ -11,6 +11,19 @@ import org.opencv.core.Mat;
 
 /// A sink for user code to accept video frames as OpenCV images.
 public class CvSink extends VideoSink {
+  public enum DeliveryMode {
+    kLatest(0), kFifo(1), kEveryNth(2);
+    private int value;
+
+    private DeliveryMode(int value) {
+      this.value = value;
+    }
+
+    public int getValue() {
+      return value;
+    }
+  }
+
   /// Create a sink for accepting OpenCV images.
   /// WaitForFrame() must be called on the created sink to get each new
   /// image.
@@ -46,6 +59,39 @@ public class CvSink extends VideoSink {
     return CameraServerJNI.grabSinkFrame(m_handle, image.nativeObj);
   }
 
+  /// Wait for the next frame and get the image.  Times out (returning 0)
+  /// after timeout seconds.
+  /// The provided image will have three 3-bit channels stored in BGR order.
+  /// @return Frame time, or 0 on error or timeout (call GetError() to obtain
+  ///         the error message);
+  public long grabFrame(Mat image, double timeout) {
+    return CameraServerJNI.grabSinkFrameTimeout(m_handle, image.nativeObj, timeout);
+  }
+
+  /// Wait until at least one of the sinks has a new frame, so that one
+  /// thread can service several cameras.  grabFrame() on a returned sink
+  /// returns that frame without waiting (unless its source is changed in
+  /// the meantime).  A sink's source may be changed during the wait; the
+  /// new source is picked up within 100 ms.
+  /// @param sinks Sinks to wait on
+  /// @param timeout Timeout in seconds (negative to wait forever)
+  /// @return Sinks with new frames; empty on timeout
+  public static CvSink[] waitForAnyFrame(CvSink[] sinks, double timeout) {
+    int[] handles = new int[sinks.length];
+    for (int i=0; i<sinks.length; i++) {
+      handles[i] = sinks[i].m_handle;
+    }
+    int[] ready = CameraServerJNI.waitForAnySinkFrame(handles, timeout);
+    CvSink[] rv = new CvSink[ready.length];
+    int j = 0;
+    for (int i=0; i<sinks.length && j<ready.length; i++) {
+      if (handles[i] == ready[j]) {
+        rv[j++] = sinks[i];
+      }
+    }
+    return rv;
+  }
+
   /// Get error string.  Call this if WaitForFrame() returns 0 to determine
   /// what the error is.
   public String getError() {
@@ -59,4 +105,24 @@ public class CvSink extends VideoSink {
   public void setEnabled(boolean enabled) {
     CameraServerJNI.setSinkEnabled(m_handle, enabled);
   }
+
+  /// Set how frames are delivered to grabFrame().
+  /// kLatest (the default) returns only the most recent frame.  kFifo queues
+  /// up to param frames, so every frame is seen unless the queue overflows.
+  /// kEveryNth returns the most recent of every param frames.
+  /// @param mode Delivery mode
+  /// @param param FIFO depth (kFifo) or N (kEveryNth); ignored for kLatest
+  public void setDeliveryMode(DeliveryMode mode, int param) {
+    CameraServerJNI.setSinkDeliveryMode(m_handle, mode.getValue(), param);
+  }
+
+  /// Get the number of frames returned by grabFrame().
+  public long getFramesDelivered() {
+    return CameraServerJNI.getSinkFramesDelivered(m_handle);
+  }
+
+  /// Get the number of frames dropped (never returned by grabFrame()).
+  public long getFramesDropped() {
+    return CameraServerJNI.getSinkFramesDropped(m_handle);
+  }
 }
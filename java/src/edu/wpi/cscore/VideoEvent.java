@@ -25,7 +25,9 @@ public class VideoEvent {
     kSinkDestroyed(0x0800),
     kSinkEnabled(0x1000),
     kSinkDisabled(0x2000),
-    kNetworkInterfacesChanged(0x4000);
+    kNetworkInterfacesChanged(0x4000),
+    kUsbCamerasChanged(0x8000),
+    kSourceFramesDropped(0x10000);
 
     private int value;
 
@@ -55,6 +57,8 @@ public class VideoEvent {
       case 0x1000: return Kind.kSinkEnabled;
       case 0x2000: return Kind.kSinkDisabled;
       case 0x4000: return Kind.kNetworkInterfacesChanged;
+      case 0x8000: return Kind.kUsbCamerasChanged;
+      case 0x10000: return Kind.kSourceFramesDropped;
       default: return Kind.kUnknown;
     }
   }
@@ -7,7 +7,11 @@
 
 #include "CvSinkImpl.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include "llvm/SmallString.h"
+#include "llvm/SmallVector.h"
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
 #include "opencv2/highgui/highgui.hpp"
@@ -20,6 +24,9 @@
 
 using namespace cs;
 
+// How often WaitForAnySinkFrame() checks for sinks whose source changed
+static constexpr std::chrono::milliseconds kSourceRecheckInterval{100};
+
 CvSinkImpl::CvSinkImpl(llvm::StringRef name) : SinkImpl{name} {
   m_active = true;
   // m_thread = std::thread(&CvSinkImpl::ThreadMain, this);
@@ -29,7 +36,13 @@ CvSinkImpl::CvSinkImpl(llvm::StringRef name,
                        std::function<void(uint64_t time)> processFrame)
     : SinkImpl{name} {}
 
-CvSinkImpl::~CvSinkImpl() { Stop(); }
+CvSinkImpl::~CvSinkImpl() {
+  Stop();
+  std::lock_guard<std::mutex> lock(m_queueMutex);
+  if (m_queueSource) m_queueSource->RemoveFrameQueue(&m_frameQueue);
+  if (m_hintSource)
+    m_hintSource->RemoveConversionHint(0, 0, VideoMode::kBGR, 80);
+}
 
 void CvSinkImpl::Stop() {
   m_active = false;
@@ -42,30 +55,367 @@ void CvSinkImpl::Stop() {
   if (m_thread.joinable()) m_thread.join();
 }
 
-uint64_t CvSinkImpl::GrabFrame(cv::Mat& image) {
+uint64_t CvSinkImpl::GrabFrame(cv::Mat& image, CS_FrameMetadata* metadata) {
   SetEnabled(true);
+  m_timedOut = false;
 
-  auto source = GetSource();
+  // Wait (a bounded amount of time) for a source to be connected
+  auto source = WaitForSource(1.0);
+  if (!source) return 0;
+
+  // Frames are waited for by sequence number, so an error frame doesn't
+  // cause a busy loop; no need to sleep here.
+  CS_Status status = 0;
+  auto frame = GetNextFrame(*source, -1, &status);  // blocks
+  if (!frame || !frame.GetCv(image)) return 0;  // signal error
+  ++m_framesDelivered;
+  if (metadata) frame.GetMetadata(metadata);
+
+  return frame.GetTime();
+}
+
+uint64_t CvSinkImpl::GrabFrame(cv::Mat& image, double timeout,
+                               CS_Status* status, CS_FrameMetadata* metadata) {
+  SetEnabled(true);
+  m_timedOut = false;
+
+  auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(timeout));
+
+  auto source = WaitForSource(timeout);
   if (!source) {
-    // Source disconnected; sleep for one second
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    m_timedOut = true;
+    *status = CS_TIMED_OUT;
     return 0;
   }
 
-  auto frame = source->GetNextFrame();  // blocks
-  if (!frame) {
-    // Bad frame; sleep for 20 ms so we don't consume all processor time.
-    std::this_thread::sleep_for(std::chrono::milliseconds(20));
-    return 0;  // signal error
+  std::chrono::duration<double> remaining =
+      deadline - std::chrono::steady_clock::now();
+  // Returns immediately if a frame is already available (e.g. after the sink
+  // eventfd became readable).
+  auto frame = GetNextFrame(*source, std::max(remaining.count(), 0.0), status);
+  if (*status == CS_TIMED_OUT) {
+    m_timedOut = true;
+    return 0;
+  }
+  if (!frame || !frame.GetCv(image)) return 0;  // signal error
+  ++m_framesDelivered;
+  if (metadata) frame.GetMetadata(metadata);
+
+  return frame.GetTime();
+}
+
+uint64_t CvSinkImpl::GrabFrameAfter(cv::Mat& image, uint64_t sequence,
+                                    uint64_t* frameSequence,
+                                    uint64_t* skipped) {
+  SetEnabled(true);
+  m_timedOut = false;
+  if (frameSequence) *frameSequence = 0;
+  if (skipped) *skipped = 0;
+
+  auto source = WaitForSource(1.0);
+  if (!source) return 0;
+
+  auto frame =
+      source->GetNextFrame(sequence, skipped, GetPriority());  // blocks
+  m_lastSequence = frame.GetSequence();
+  if (frameSequence) *frameSequence = m_lastSequence;
+  if (!frame || !frame.GetCv(image)) return 0;  // signal error
+
+  return frame.GetTime();
+}
+
+uint64_t CvSinkImpl::GrabFrameNearTime(cv::Mat& image, uint64_t time,
+                                       uint64_t* frameSequence) {
+  // Keep the source running so the frame ring stays populated
+  SetEnabled(true);
+  if (frameSequence) *frameSequence = 0;
+
+  auto source = GetSource();
+  if (!source) return 0;
+
+  auto frame = source->GetFrameNearTime(time);  // does not block
+  if (!frame || !frame.GetCv(image)) return 0;
+
+  if (frameSequence) *frameSequence = frame.GetSequence();
+  return frame.GetTime();
+}
+
+void CvSinkImpl::SetDeliveryMode(CS_SinkDeliveryMode mode, int param,
+                                 CS_Status* status) {
+  std::size_t depth = 1;
+  int every = 1;
+  switch (mode) {
+    case CS_SINK_DELIVER_LATEST:
+      break;
+    case CS_SINK_DELIVER_FIFO:
+      if (param < 1) {
+        *status = CS_INVALID_PARAMETER;
+        return;
+      }
+      depth = param;
+      break;
+    case CS_SINK_DELIVER_EVERY_NTH:
+      if (param < 1) {
+        *status = CS_INVALID_PARAMETER;
+        return;
+      }
+      every = param;
+      break;
+    default:
+      *status = CS_INVALID_PARAMETER;
+      return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_frameQueue.mutex);
+    m_frameQueue.depth = depth;
+    m_frameQueue.every = every;
+    m_frameQueue.count = 0;
+    while (m_frameQueue.frames.size() > depth) {
+      m_frameQueue.frames.pop_front();
+      ++m_frameQueue.dropped;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_deliveryMode = mode;
+  }
+  UpdateFrameQueue(GetSource());
+}
+
+uint64_t CvSinkImpl::GetFramesDropped() {
+  std::lock_guard<std::mutex> lock(m_frameQueue.mutex);
+  return m_framesDropped + m_frameQueue.dropped;
+}
+
+bool CvSinkImpl::HasNewFrame() {
+  auto source = GetSource();
+  if (!source) return false;
+  {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    if (m_deliveryMode != CS_SINK_DELIVER_LATEST &&
+        m_queueSource == source) {
+      std::lock_guard<std::mutex> queueLock(m_frameQueue.mutex);
+      return !m_frameQueue.frames.empty();
+    }
   }
+  return source->GetCurFrameSequence() > GetWaitSequence(*source);
+}
+
+uint64_t CvSinkImpl::GetWaitSequence(SourceImpl& source) const {
+  uint64_t lastSequence = m_lastSequence;
+  if (!m_resumed || lastSequence == 0) return lastSequence;
+
+  // Frames put while this sink was disabled weren't missed by it.  The
+  // current frame is taken only if it is recent (e.g. put while the source
+  // lingered or was in standby); otherwise the sink waits for a fresh one.
+  Frame frame = source.GetCurFrame();
+  uint64_t sequence = frame.GetSequence();
+  if (sequence <= lastSequence) return lastSequence;
+  return SourceImpl::IsRecentFrame(frame) ? sequence - 1 : sequence;
+}
 
-  if (!frame.GetCv(image)) {
-    // Shouldn't happen, but just in case...
-    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+Frame CvSinkImpl::GetNextFrame(SourceImpl& source, double timeout,
+                               CS_Status* status) {
+  bool queued;
+  {
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    queued = m_deliveryMode != CS_SINK_DELIVER_LATEST &&
+             m_queueSource.get() == &source;
+  }
+  if (queued) {
+    auto frame = source.GetQueuedFrame(m_frameQueue, timeout, status,
+                                       GetPriority());
+    if (frame) m_lastSequence = frame.GetSequence();
+    return frame;
+  }
+
+  // Latest-only; frames skipped since the last grab count as dropped.
+  // Waiting by sequence number returns a frame newer than the last grab
+  // right away (as reported by HasNewFrame()), and hands a first grab a
+  // recent frame rather than waiting for the next one.
+  uint64_t lastSequence = GetWaitSequence(source);
+  Frame frame =
+      source.GetNextFrame(lastSequence, timeout, status, GetPriority());
+  if (*status == CS_TIMED_OUT) return frame;
+  m_resumed = false;
+  uint64_t sequence = frame.GetSequence();
+  if (lastSequence != 0 && sequence > lastSequence + 1)
+    m_framesDropped += sequence - lastSequence - 1;
+  m_lastSequence = sequence;
+  return frame;
+}
+
+void CvSinkImpl::UpdateFrameQueue(std::shared_ptr<SourceImpl> source) {
+  std::lock_guard<std::mutex> lock(m_queueMutex);
+  if (m_deliveryMode == CS_SINK_DELIVER_LATEST) source.reset();
+  if (m_queueSource == source) return;
+  if (m_queueSource) m_queueSource->RemoveFrameQueue(&m_frameQueue);
+  {
+    std::lock_guard<std::mutex> queueLock(m_frameQueue.mutex);
+    m_frameQueue.frames.clear();
+    m_frameQueue.count = 0;
+  }
+  m_queueSource = source;
+  if (m_queueSource) m_queueSource->AddFrameQueue(&m_frameQueue);
+}
+
+uint64_t CvSinkImpl::GrabFramesSync(llvm::ArrayRef<CvSinkImpl*> sinks,
+                                    llvm::MutableArrayRef<cv::Mat> images,
+                                    double tolerance, double timeout,
+                                    uint64_t* skew, uint64_t* dropped,
+                                    CS_Status* status) {
+  if (skew) *skew = 0;
+  if (dropped) *dropped = 0;
+  std::size_t count = sinks.size();
+
+  auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(timeout));
+  // frame times are in 100 ns units
+  auto toleranceTime = static_cast<Frame::Time>(tolerance * 10000000.0);
+
+  for (auto sink : sinks) {
+    sink->SetEnabled(true);
+    sink->m_timedOut = false;
+  }
+
+  llvm::SmallVector<std::shared_ptr<SourceImpl>, 4> sources(count);
+  llvm::SmallVector<Frame, 4> frames(count);
+  for (;;) {
+    for (auto sink : sinks) {
+      if (!sink->m_active) return 0;
+    }
+
+    // Every source must have a frame newer than the last one grabbed by its
+    // sink.  The source with the oldest latest frame sets the target time.
+    std::size_t waitIndex = count;
+    uint64_t waitSequence = 0;
+    Frame::Time target = 0;
+    std::size_t targetIndex = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      sources[i] = sinks[i]->GetSource();
+      if (!sources[i]) {
+        waitIndex = i;
+        break;
+      }
+      uint64_t lastSequence = sinks[i]->m_lastSequence;
+      Frame latest = sources[i]->GetCurFrame();
+      if (!latest || latest.GetSequence() <= lastSequence) {
+        // error frames don't count, but don't busy-wait on them either
+        waitIndex = i;
+        waitSequence = std::max(latest.GetSequence(), lastSequence);
+        break;
+      }
+      if (i == 0 || latest.GetTime() < target) {
+        target = latest.GetTime();
+        targetIndex = i;
+        waitSequence = latest.GetSequence();
+      }
+    }
+
+    if (waitIndex == count) {
+      // Pick the frame nearest the target time from each source
+      Frame::Time minTime = target;
+      Frame::Time maxTime = target;
+      bool matched = true;
+      for (std::size_t i = 0; i < count; ++i) {
+        frames[i] =
+            sources[i]->GetFrameNearTime(target, sinks[i]->m_lastSequence);
+        if (!frames[i]) {
+          matched = false;
+          break;
+        }
+        minTime = std::min(minTime, frames[i].GetTime());
+        maxTime = std::max(maxTime, frames[i].GetTime());
+      }
+
+      if (matched && maxTime - minTime <= toleranceTime) {
+        bool ok = true;
+        for (std::size_t i = 0; i < count; ++i) {
+          CvSinkImpl& sink = *sinks[i];
+          uint64_t lastSequence = sink.m_lastSequence;
+          uint64_t sequence = frames[i].GetSequence();
+          if (lastSequence != 0 && sequence > lastSequence + 1) {
+            sink.m_framesDropped += sequence - lastSequence - 1;
+            if (dropped) *dropped += sequence - lastSequence - 1;
+          }
+          sink.m_lastSequence = sequence;
+          if (!frames[i].GetCv(images[i]))
+            ok = false;
+          else
+            ++sink.m_framesDelivered;
+        }
+        if (skew) *skew = maxTime - minTime;
+        if (!ok) return 0;  // signal error
+        return minTime;
+      }
+
+      // The other sources have no frame close enough to the oldest one, so
+      // wait for the oldest source to produce a newer frame.
+      waitIndex = targetIndex;
+    }
+
+    std::chrono::duration<double> remaining =
+        deadline - std::chrono::steady_clock::now();
+    if (remaining.count() > 0) {
+      if (!sources[waitIndex]) {
+        sinks[waitIndex]->WaitForSource(remaining.count());
+        continue;
+      }
+      CS_Status waitStatus = 0;
+      sources[waitIndex]->GetNextFrame(waitSequence, remaining.count(),
+                                       &waitStatus,
+                                       sinks[waitIndex]->GetPriority());
+      if (waitStatus != CS_TIMED_OUT) continue;
+    }
+
+    for (auto sink : sinks) sink->m_timedOut = true;
+    *status = CS_TIMED_OUT;
     return 0;
   }
+}
 
-  return frame.GetTime();
+std::string CvSinkImpl::GetError() const {
+  if (m_timedOut) return "timed out waiting for frame";
+  return SinkImpl::GetError();
+}
+
+llvm::StringRef CvSinkImpl::GetError(llvm::SmallVectorImpl<char>& buf) const {
+  if (m_timedOut) return "timed out waiting for frame";
+  return SinkImpl::GetError(buf);
+}
+
+void CvSinkImpl::SetEnabledImpl(bool enabled) {
+  if (enabled) m_resumed = true;
+  std::lock_guard<std::mutex> lock(m_queueMutex);
+  m_enabled = enabled;
+  UpdateConversionHint();
+}
+
+void CvSinkImpl::SetSourceImpl(std::shared_ptr<SourceImpl> source) {
+  // Sequence numbers are per-source
+  m_lastSequence = 0;
+  UpdateFrameQueue(source);
+
+  std::lock_guard<std::mutex> lock(m_queueMutex);
+  m_connectedSource = source;
+  UpdateConversionHint();
+}
+
+void CvSinkImpl::UpdateConversionHint() {
+  // GrabFrame() gets BGR images at the original size; have the source
+  // convert to that as soon as each frame arrives.  Like MjpegServer, only
+  // hint while frames are actually wanted.
+  auto source = m_enabled ? m_connectedSource : nullptr;
+  if (m_hintSource == source) return;
+  if (m_hintSource)
+    m_hintSource->RemoveConversionHint(0, 0, VideoMode::kBGR, 80);
+  m_hintSource = source;
+  if (m_hintSource) m_hintSource->AddConversionHint(0, 0, VideoMode::kBGR, 80);
 }
 
 // Send HTTP response and a stream of JPG-frames
@@ -128,6 +478,150 @@ uint64_t GrabSinkFrame(CS_Sink sink, cv::Mat& image, CS_Status* status) {
   return static_cast<CvSinkImpl&>(*data->sink).GrabFrame(image);
 }
 
+uint64_t GrabSinkFrameTimeout(CS_Sink sink, cv::Mat& image, double timeout,
+                              CS_Status* status) {
+  auto data = Sinks::GetInstance().Get(sink);
+  if (!data || data->kind != CS_SINK_CV) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return static_cast<CvSinkImpl&>(*data->sink)
+      .GrabFrame(image, timeout, status);
+}
+
+uint64_t GrabSinkFrameMetadata(CS_Sink sink, cv::Mat& image, double timeout,
+                               CS_FrameMetadata* metadata, CS_Status* status) {
+  auto data = Sinks::GetInstance().Get(sink);
+  if (!data || data->kind != CS_SINK_CV) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  auto& cvSink = static_cast<CvSinkImpl&>(*data->sink);
+  if (timeout < 0) return cvSink.GrabFrame(image, metadata);
+  return cvSink.GrabFrame(image, timeout, status, metadata);
+}
+
+uint64_t GrabSinkFrameAfter(CS_Sink sink, cv::Mat& image, uint64_t sequence,
+                            uint64_t* frameSequence, uint64_t* skipped,
+                            CS_Status* status) {
+  auto data = Sinks::GetInstance().Get(sink);
+  if (!data || data->kind != CS_SINK_CV) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return static_cast<CvSinkImpl&>(*data->sink)
+      .GrabFrameAfter(image, sequence, frameSequence, skipped);
+}
+
+uint64_t GrabSinkFrameNearTime(CS_Sink sink, cv::Mat& image, uint64_t time,
+                               uint64_t* frameSequence, CS_Status* status) {
+  auto data = Sinks::GetInstance().Get(sink);
+  if (!data || data->kind != CS_SINK_CV) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return static_cast<CvSinkImpl&>(*data->sink)
+      .GrabFrameNearTime(image, time, frameSequence);
+}
+
+uint64_t GrabSinkFramesSync(llvm::ArrayRef<CS_Sink> sinks,
+                            llvm::MutableArrayRef<cv::Mat> images,
+                            double tolerance, double timeout, uint64_t* skew,
+                            uint64_t* dropped, CS_Status* status) {
+  if (sinks.empty() || images.size() < sinks.size()) {
+    *status = CS_INVALID_PARAMETER;
+    return 0;
+  }
+  // Keep the sinks alive while waiting
+  llvm::SmallVector<std::shared_ptr<SinkImpl>, 4> impls;
+  llvm::SmallVector<CvSinkImpl*, 4> cvSinks;
+  for (auto sink : sinks) {
+    auto data = Sinks::GetInstance().Get(sink);
+    if (!data || data->kind != CS_SINK_CV) {
+      *status = CS_INVALID_HANDLE;
+      return 0;
+    }
+    impls.push_back(data->sink);
+    cvSinks.push_back(&static_cast<CvSinkImpl&>(*data->sink));
+  }
+  return CvSinkImpl::GrabFramesSync(cvSinks, images, tolerance, timeout, skew,
+                                    dropped, status);
+}
+
+llvm::ArrayRef<CS_Sink> WaitForAnySinkFrame(llvm::ArrayRef<CS_Sink> sinks,
+                                            double timeout,
+                                            llvm::SmallVectorImpl<CS_Sink>& vec,
+                                            CS_Status* status) {
+  vec.clear();
+  llvm::SmallVector<std::shared_ptr<SinkImpl>, 8> impls;  // keep alive
+  llvm::SmallVector<CvSinkImpl*, 8> cvSinks;
+  for (auto sink : sinks) {
+    auto data = Sinks::GetInstance().Get(sink);
+    if (!data || data->kind != CS_SINK_CV) {
+      *status = CS_INVALID_HANDLE;
+      return vec;
+    }
+    impls.push_back(data->sink);
+    cvSinks.push_back(&static_cast<CvSinkImpl&>(*data->sink));
+    cvSinks.back()->SetEnabled(true);
+  }
+
+  // Register a single signal with every source; a frame from any of them
+  // wakes this thread.  Sinks without a source are never ready.  A sink's
+  // source may be changed while waiting, which doesn't signal, so the
+  // registrations are refreshed at least every kSourceRecheckInterval.
+  SourceImpl::FrameSignal signal;
+  llvm::SmallVector<std::shared_ptr<SourceImpl>, 8> sources;
+  auto updateSources = [&] {
+    llvm::SmallVector<std::shared_ptr<SourceImpl>, 8> current;
+    for (auto sink : cvSinks) {
+      auto source = sink->GetSource();
+      if (source &&
+          std::find(current.begin(), current.end(), source) == current.end())
+        current.push_back(source);
+    }
+    for (auto& source : sources) {
+      if (std::find(current.begin(), current.end(), source) == current.end())
+        source->RemoveFrameSignal(&signal);
+    }
+    for (auto& source : current) {
+      if (std::find(sources.begin(), sources.end(), source) == sources.end())
+        source->AddFrameSignal(&signal);
+    }
+    sources.swap(current);
+  };
+
+  auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(timeout));
+  for (;;) {
+    // Clear before checking so a frame arriving after the check is not lost
+    {
+      std::lock_guard<std::mutex> lock(signal.mutex);
+      signal.signaled = false;
+    }
+    updateSources();
+    for (std::size_t i = 0; i < cvSinks.size(); ++i) {
+      if (cvSinks[i]->HasNewFrame()) vec.push_back(sinks[i]);
+    }
+    if (!vec.empty()) break;
+
+    auto now = std::chrono::steady_clock::now();
+    if (timeout >= 0 && now >= deadline) {
+      *status = CS_TIMED_OUT;
+      break;
+    }
+    auto wakeup = now + kSourceRecheckInterval;
+    if (timeout >= 0 && deadline < wakeup) wakeup = deadline;
+    std::unique_lock<std::mutex> lock(signal.mutex);
+    signal.cv.wait_until(lock, wakeup, [&] { return signal.signaled; });
+  }
+
+  for (auto& source : sources) source->RemoveFrameSignal(&signal);
+  return vec;
+}
+
 std::string GetSinkError(CS_Sink sink, CS_Status* status) {
   auto data = Sinks::GetInstance().Get(sink);
   if (!data || data->kind != CS_SINK_CV) {
@@ -156,6 +650,34 @@ void SetSinkEnabled(CS_Sink sink, bool enabled, CS_Status* status) {
   static_cast<CvSinkImpl&>(*data->sink).SetEnabled(enabled);
 }
 
+void SetSinkDeliveryMode(CS_Sink sink, CS_SinkDeliveryMode mode, int param,
+                         CS_Status* status) {
+  auto data = Sinks::GetInstance().Get(sink);
+  if (!data || data->kind != CS_SINK_CV) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  static_cast<CvSinkImpl&>(*data->sink).SetDeliveryMode(mode, param, status);
+}
+
+uint64_t GetSinkFramesDelivered(CS_Sink sink, CS_Status* status) {
+  auto data = Sinks::GetInstance().Get(sink);
+  if (!data || data->kind != CS_SINK_CV) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return static_cast<CvSinkImpl&>(*data->sink).GetFramesDelivered();
+}
+
+uint64_t GetSinkFramesDropped(CS_Sink sink, CS_Status* status) {
+  auto data = Sinks::GetInstance().Get(sink);
+  if (!data || data->kind != CS_SINK_CV) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return static_cast<CvSinkImpl&>(*data->sink).GetFramesDropped();
+}
+
 }  // namespace cs
 
 extern "C" {
@@ -186,6 +708,99 @@ uint64_t CS_GrabSinkFrameCpp(CS_Sink sink, cv::Mat* image, CS_Status* status) {
    return cs::GrabSinkFrame(sink, *image, status);
 }
 
+uint64_t CS_GrabSinkFrameTimeout(CS_Sink sink, struct CvMat* image,
+                                 double timeout, CS_Status* status) {
+  auto mat = cv::cvarrToMat(image);
+  return cs::GrabSinkFrameTimeout(sink, mat, timeout, status);
+}
+
+uint64_t CS_GrabSinkFrameTimeoutCpp(CS_Sink sink, cv::Mat* image,
+                                    double timeout, CS_Status* status) {
+  return cs::GrabSinkFrameTimeout(sink, *image, timeout, status);
+}
+
+uint64_t CS_GrabSinkFrameMetadata(CS_Sink sink, struct CvMat* image,
+                                  double timeout, CS_FrameMetadata* metadata,
+                                  CS_Status* status) {
+  auto mat = cv::cvarrToMat(image);
+  return cs::GrabSinkFrameMetadata(sink, mat, timeout, metadata, status);
+}
+
+uint64_t CS_GrabSinkFrameMetadataCpp(CS_Sink sink, cv::Mat* image,
+                                     double timeout,
+                                     CS_FrameMetadata* metadata,
+                                     CS_Status* status) {
+  return cs::GrabSinkFrameMetadata(sink, *image, timeout, metadata, status);
+}
+
+uint64_t CS_GrabSinkFrameAfter(CS_Sink sink, struct CvMat* image,
+                               uint64_t sequence, uint64_t* frameSequence,
+                               uint64_t* skipped, CS_Status* status) {
+  auto mat = cv::cvarrToMat(image);
+  return cs::GrabSinkFrameAfter(sink, mat, sequence, frameSequence, skipped,
+                                status);
+}
+
+uint64_t CS_GrabSinkFrameAfterCpp(CS_Sink sink, cv::Mat* image,
+                                  uint64_t sequence, uint64_t* frameSequence,
+                                  uint64_t* skipped, CS_Status* status) {
+  return cs::GrabSinkFrameAfter(sink, *image, sequence, frameSequence, skipped,
+                                status);
+}
+
+uint64_t CS_GrabSinkFrameNearTime(CS_Sink sink, struct CvMat* image,
+                                  uint64_t time, uint64_t* frameSequence,
+                                  CS_Status* status) {
+  auto mat = cv::cvarrToMat(image);
+  return cs::GrabSinkFrameNearTime(sink, mat, time, frameSequence, status);
+}
+
+uint64_t CS_GrabSinkFrameNearTimeCpp(CS_Sink sink, cv::Mat* image,
+                                     uint64_t time, uint64_t* frameSequence,
+                                     CS_Status* status) {
+  return cs::GrabSinkFrameNearTime(sink, *image, time, frameSequence, status);
+}
+
+uint64_t CS_GrabSinkFramesSync(const CS_Sink* sinks, int count,
+                               struct CvMat** images, double tolerance,
+                               double timeout, uint64_t* skew,
+                               uint64_t* dropped, CS_Status* status) {
+  if (count < 0) {
+    *status = CS_INVALID_PARAMETER;
+    return 0;
+  }
+  llvm::SmallVector<cv::Mat, 4> mats;
+  for (int i = 0; i < count; ++i) mats.push_back(cv::cvarrToMat(images[i]));
+  return cs::GrabSinkFramesSync(llvm::makeArrayRef(sinks, count), mats,
+                                tolerance, timeout, skew, dropped, status);
+}
+
+uint64_t CS_GrabSinkFramesSyncCpp(const CS_Sink* sinks, int count,
+                                  cv::Mat* images, double tolerance,
+                                  double timeout, uint64_t* skew,
+                                  uint64_t* dropped, CS_Status* status) {
+  if (count < 0) {
+    *status = CS_INVALID_PARAMETER;
+    return 0;
+  }
+  return cs::GrabSinkFramesSync(llvm::makeArrayRef(sinks, count),
+                                llvm::MutableArrayRef<cv::Mat>(images, count),
+                                tolerance, timeout, skew, dropped, status);
+}
+
+int CS_WaitForAnySinkFrame(const CS_Sink* sinks, int count, double timeout,
+                           CS_Sink* ready, CS_Status* status) {
+  if (count < 0) {
+    *status = CS_INVALID_PARAMETER;
+    return 0;
+  }
+  llvm::SmallVector<CS_Sink, 8> buf;
+  auto vec = cs::WaitForAnySinkFrame(llvm::makeArrayRef(sinks, count), timeout,
+                                     buf, status);
+  std::copy(vec.begin(), vec.end(), ready);
+  return vec.size();
+}
+
 char* CS_GetSinkError(CS_Sink sink, CS_Status* status) {
   llvm::SmallString<128> buf;
   auto str = cs::GetSinkError(sink, buf, status);
@@ -197,4 +812,17 @@ void CS_SetSinkEnabled(CS_Sink sink, CS_Bool enabled, CS_Status* status) {
   return cs::SetSinkEnabled(sink, enabled, status);
 }
 
+void CS_SetSinkDeliveryMode(CS_Sink sink, enum CS_SinkDeliveryMode mode,
+                            int param, CS_Status* status) {
+  return cs::SetSinkDeliveryMode(sink, mode, param, status);
+}
+
+uint64_t CS_GetSinkFramesDelivered(CS_Sink sink, CS_Status* status) {
+  return cs::GetSinkFramesDelivered(sink, status);
+}
+
+uint64_t CS_GetSinkFramesDropped(CS_Sink sink, CS_Status* status) {
+  return cs::GetSinkFramesDropped(sink, status);
+}
+
 }  // extern "C"
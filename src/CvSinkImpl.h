@@ -15,6 +15,7 @@
 #include <thread>
 #include <vector>
 
+#include "llvm/ArrayRef.h"
 #include "llvm/raw_ostream.h"
 #include "llvm/SmallVector.h"
 #include "llvm/StringRef.h"
@@ -23,7 +24,9 @@
 #include "tcpsockets/NetworkAcceptor.h"
 #include "tcpsockets/NetworkStream.h"
 
+#include "cscore_c.h"
 #include "SinkImpl.h"
+#include "SourceImpl.h"
 
 namespace cs {
 
@@ -38,12 +41,67 @@ class CvSinkImpl : public SinkImpl {
 
   void Stop();
 
-  uint64_t GrabFrame(cv::Mat& image);
+  uint64_t GrabFrame(cv::Mat& image, CS_FrameMetadata* metadata = nullptr);
+  uint64_t GrabFrame(cv::Mat& image, double timeout, CS_Status* status,
+                     CS_FrameMetadata* metadata = nullptr);
+  uint64_t GrabFrameAfter(cv::Mat& image, uint64_t sequence,
+                          uint64_t* frameSequence, uint64_t* skipped);
+  uint64_t GrabFrameNearTime(cv::Mat& image, uint64_t time,
+                             uint64_t* frameSequence);
+
+  // Grabs one frame from each sink, with all frame times within tolerance
+  // seconds of each other.
+  static uint64_t GrabFramesSync(llvm::ArrayRef<CvSinkImpl*> sinks,
+                                 llvm::MutableArrayRef<cv::Mat> images,
+                                 double tolerance, double timeout,
+                                 uint64_t* skew, uint64_t* dropped,
+                                 CS_Status* status);
+
+  void SetDeliveryMode(CS_SinkDeliveryMode mode, int param,
+                       CS_Status* status);
+  uint64_t GetFramesDelivered() const { return m_framesDelivered; }
+  uint64_t GetFramesDropped();
+
+  // Returns true if GrabFrame() would return without waiting.
+  bool HasNewFrame();
+
+  std::string GetError() const override;
+  llvm::StringRef GetError(llvm::SmallVectorImpl<char>& buf) const override;
+
+ protected:
+  void SetSourceImpl(std::shared_ptr<SourceImpl> source) override;
+  void SetEnabledImpl(bool enabled) override;
 
  private:
   void ThreadMain();
 
+  // Gets the next frame according to the delivery mode.
+  Frame GetNextFrame(SourceImpl& source, double timeout, CS_Status* status);
+  // Gets the sequence number the next latest-only grab waits past.
+  uint64_t GetWaitSequence(SourceImpl& source) const;
+  // Moves the frame queue registration to source (if not latest-only).
+  void UpdateFrameQueue(std::shared_ptr<SourceImpl> source);
+  // Moves the conversion hint to the source while the sink is enabled.
+  // Must be called with m_queueMutex held.
+  void UpdateConversionHint();
+
   std::atomic_bool m_active;  // set to false to terminate threads
+  std::atomic_bool m_timedOut{false};  // last grab timed out
+  std::atomic<uint64_t> m_lastSequence{0};  // sequence of last grabbed frame
+  std::atomic_bool m_resumed{false};  // re-enabled since the last grab
+  std::atomic<uint64_t> m_framesDelivered{0};
+  std::atomic<uint64_t> m_framesDropped{0};  // latest-only mode drops
+
+  // Frame queue used by the FIFO and every-Nth delivery modes.
+  SourceImpl::FrameQueue m_frameQueue;
+  // Protects m_deliveryMode, m_queueSource and the conversion hint state.
+  mutable std::mutex m_queueMutex;
+  CS_SinkDeliveryMode m_deliveryMode{CS_SINK_DELIVER_LATEST};
+  std::shared_ptr<SourceImpl> m_queueSource;  // source m_frameQueue is in
+  std::shared_ptr<SourceImpl> m_connectedSource;  // set by SetSourceImpl()
+  bool m_enabled{false};  // set by SetEnabledImpl()
+  std::shared_ptr<SourceImpl> m_hintSource;  // source with our conversion hint
+
   std::thread m_thread;
   std::function<void(uint64_t time)> m_processFrame;
 };
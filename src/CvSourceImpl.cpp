@@ -131,6 +131,10 @@ void CvSourceImpl::NumSinksEnabledChanged() {
 }
 
 void CvSourceImpl::PutFrame(cv::Mat& image) {
+  // Drop frames over the rate limit before copying them
+  auto time = wpi::Now();
+  if (!ShouldPublishFrame(time)) return;
+
   // We only support 8-bit images; convert if necessary.
   cv::Mat finalImage;
   if (image.depth() == CV_8U)
@@ -160,7 +164,7 @@ void CvSourceImpl::PutFrame(cv::Mat& image) {
                           << "-channel images not supported");
       return;
   }
-  SourceImpl::PutFrame(std::move(dest), wpi::Now());
+  SourceImpl::PutFrame(std::move(dest), time);
 }
 
 void CvSourceImpl::NotifyError(llvm::StringRef msg) {
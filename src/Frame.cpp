@@ -21,6 +21,10 @@ Frame::Frame(SourceImpl& source, llvm::StringRef error, Time time)
   m_impl->refcount = 1;
   m_impl->error = error;
   m_impl->time = time;
+  m_impl->sequence = 0;
+  m_impl->captureSequence = 0;
+  m_impl->dequeueTime = time;
+  m_impl->publishTime = 0;
 }
 
 Frame::Frame(SourceImpl& source, std::unique_ptr<Image> image, Time time)
@@ -28,6 +32,10 @@ Frame::Frame(SourceImpl& source, std::unique_ptr<Image> image, Time time)
   m_impl->refcount = 1;
   m_impl->error.resize(0);
   m_impl->time = time;
+  m_impl->sequence = 0;
+  m_impl->captureSequence = 0;
+  m_impl->dequeueTime = time;
+  m_impl->publishTime = 0;
   m_impl->images.push_back(image.release());
 }
 
@@ -34,6 +34,11 @@ class Frame {
     std::recursive_mutex mutex;
     std::atomic_int refcount{0};
     Time time{0};
+    uint64_t sequence{0};
+    // Capture metadata; time is the capture time.
+    uint64_t captureSequence{0};
+    Time dequeueTime{0};
+    Time publishTime{0};
     SourceImpl& source;
     std::string error;
     llvm::SmallVector<Image*, 4> images;
@@ -69,6 +74,34 @@ class Frame {
 
   Time GetTime() const { return m_impl ? m_impl->time : 0; }
 
+  // Must only be called on a non-empty frame.
+  SourceImpl& GetSource() const { return m_impl->source; }
+
+  // Sequence number assigned by the source when the frame was published.
+  // Empty frames (e.g. from SourceImpl::Wakeup()) have a sequence of 0.
+  uint64_t GetSequence() const { return m_impl ? m_impl->sequence : 0; }
+
+  // Sequence number assigned by the driver (e.g. V4L2); 0 for sources
+  // without one.
+  uint64_t GetCaptureSequence() const {
+    return m_impl ? m_impl->captureSequence : 0;
+  }
+
+  // Time the frame was received from the device.  The difference from
+  // GetTime() is the capture-to-dequeue latency.
+  Time GetDequeueTime() const { return m_impl ? m_impl->dequeueTime : 0; }
+
+  // Time the frame was made available to sinks.
+  Time GetPublishTime() const { return m_impl ? m_impl->publishTime : 0; }
+
+  void GetMetadata(CS_FrameMetadata* metadata) const {
+    metadata->sequence = GetSequence();
+    metadata->captureTime = GetTime();
+    metadata->captureSequence = GetCaptureSequence();
+    metadata->dequeueTime = GetDequeueTime();
+    metadata->publishTime = GetPublishTime();
+  }
+
   llvm::StringRef GetError() const {
     if (!m_impl) return llvm::StringRef{};
     return m_impl->error;
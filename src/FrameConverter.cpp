@@ -0,0 +1,112 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "FrameConverter.h"
+
+#include <algorithm>
+
+#include "Log.h"
+
+using namespace cs;
+
+ATOMIC_STATIC_INIT(FrameConverter)
+
+bool FrameConverter::s_destroyed = false;
+
+// Maximum number of worker threads
+static constexpr unsigned int kMaxThreads = 4;
+
+// Maximum number of queued conversions; if sinks register more formats than
+// the workers can keep up with, the oldest are dropped (the sinks will
+// convert lazily as before).
+static constexpr std::size_t kMaxTasks = 32;
+
+FrameConverter::FrameConverter() { s_destroyed = false; }
+
+FrameConverter::~FrameConverter() {
+  s_destroyed = true;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+    m_tasks.clear();
+  }
+  m_taskCv.notify_all();
+  for (auto& thread : m_threads) {
+    if (thread.joinable()) thread.join();
+  }
+}
+
+void FrameConverter::Convert(const Frame& frame, int width, int height,
+                             VideoMode::PixelFormat pixelFormat,
+                             int jpegQuality) {
+  if (!frame) return;
+  if (width == 0) width = frame.GetOriginalWidth();
+  if (height == 0) height = frame.GetOriginalHeight();
+  // Nothing to do if the image already exists
+  if (frame.GetExistingImage(width, height, pixelFormat)) return;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stop) return;
+
+    // Start the workers on first use
+    if (m_threads.empty()) {
+      unsigned int numThreads = std::thread::hardware_concurrency();
+      if (numThreads > kMaxThreads) numThreads = kMaxThreads;
+      if (numThreads == 0) numThreads = 1;
+      for (unsigned int i = 0; i < numThreads; ++i)
+        m_threads.emplace_back(&FrameConverter::ThreadMain, this);
+    }
+
+    while (m_tasks.size() >= kMaxTasks) m_tasks.pop_front();
+    m_tasks.emplace_back(Task{frame, &frame.GetSource(), width, height,
+                              pixelFormat, jpegQuality});
+  }
+  m_taskCv.notify_one();
+}
+
+void FrameConverter::Cancel(const SourceImpl& source) {
+  std::deque<Task> cancelled;  // destroy frames outside the lock
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (auto it = m_tasks.begin(); it != m_tasks.end();) {
+    if (it->source == &source) {
+      cancelled.emplace_back(std::move(*it));
+      it = m_tasks.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  m_doneCv.wait(lock, [&] {
+    return std::find(m_active.begin(), m_active.end(), &source) ==
+           m_active.end();
+  });
+  lock.unlock();
+  cancelled.clear();
+}
+
+void FrameConverter::ThreadMain() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stop) {
+    m_taskCv.wait(lock, [&] { return m_stop || !m_tasks.empty(); });
+    if (m_stop) break;
+
+    Task task = std::move(m_tasks.front());
+    m_tasks.pop_front();
+    m_active.push_back(task.source);
+    lock.unlock();
+
+    DEBUG4("eager conversion to " << task.width << "x" << task.height
+                                  << " type " << task.pixelFormat);
+    task.frame.GetImage(task.width, task.height, task.pixelFormat,
+                        task.jpegQuality);
+    task.frame = Frame{};  // release before signaling done
+
+    lock.lock();
+    m_active.erase(std::find(m_active.begin(), m_active.end(), task.source));
+    m_doneCv.notify_all();
+  }
+}
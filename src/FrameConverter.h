@@ -0,0 +1,78 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef CS_FRAMECONVERTER_H_
+#define CS_FRAMECONVERTER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "support/atomic_static.h"
+
+#include "Frame.h"
+
+namespace cs {
+
+class SourceImpl;
+
+// Worker pool that performs frame conversions (Frame::GetImage()) eagerly,
+// as soon as a frame is published, so that sinks waking up for the frame
+// find the image they want already converted (or being converted).
+class FrameConverter {
+ public:
+  static FrameConverter& GetInstance() {
+    ATOMIC_STATIC(FrameConverter, instance);
+    return instance;
+  }
+  ~FrameConverter();
+
+  // The instance is created lazily, so it may be destroyed before sources
+  // are at exit; it must not be used once this returns true.
+  static bool destroyed() { return s_destroyed; }
+
+  // Queues a conversion of frame.  A width/height of 0 means the original
+  // frame size.
+  void Convert(const Frame& frame, int width, int height,
+               VideoMode::PixelFormat pixelFormat, int jpegQuality);
+
+  // Drops queued conversions for frames from source and waits for any in
+  // progress to finish.  Must be called before source is destroyed.
+  void Cancel(const SourceImpl& source);
+
+ private:
+  FrameConverter();
+
+  void ThreadMain();
+
+  struct Task {
+    Frame frame;
+    const SourceImpl* source;
+    int width;
+    int height;
+    VideoMode::PixelFormat pixelFormat;
+    int jpegQuality;
+  };
+
+  std::mutex m_mutex;
+  std::condition_variable m_taskCv;
+  std::condition_variable m_doneCv;
+  std::deque<Task> m_tasks;
+  // Sources of the conversions currently in progress (one per worker)
+  std::vector<const SourceImpl*> m_active;
+  std::vector<std::thread> m_threads;
+  bool m_stop{false};
+
+  ATOMIC_STATIC_DECL(FrameConverter)
+  static bool s_destroyed;
+};
+
+}  // namespace cs
+
+#endif  // CS_FRAMECONVERTER_H_
@@ -196,6 +196,13 @@ void HttpCameraImpl::DeviceStream(wpi::raw_istream& is,
       ++numErrors;
     else
       numErrors = 0;
+
+    // Switch modes (and reconnect) if auto video mode wants to
+    VideoMode autoMode;
+    if (CheckAutoVideoMode(&autoMode)) {
+      CS_Status status = 0;
+      SetVideoMode(autoMode, &status);
+    }
   }
 }
 
@@ -235,6 +242,15 @@ bool HttpCameraImpl::DeviceStreamFrame(wpi::raw_istream& is,
     return true;
   }
  
+  // Frames over the rate limit are read into the reusable buffer and
+  // discarded.
+  auto time = wpi::Now();
+  if (!ShouldPublishFrame(time)) {
+    imageBuf.resize(contentLength);
+    is.read(&imageBuf[0], contentLength);
+    return m_active && !is.has_error();
+  }
+
   // We know how big it is!  Just get a frame of the right size and read
   // the data directly into it.
   auto image = AllocImage(VideoMode::PixelFormat::kMJPEG, 0, 0, contentLength);
@@ -248,7 +264,7 @@ bool HttpCameraImpl::DeviceStreamFrame(wpi::raw_istream& is,
   }
   image->width = width;
   image->height = height;
-  PutFrame(std::move(image), wpi::Now());
+  PutFrame(std::move(image), time);
   return true;
 }
 
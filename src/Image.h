@@ -8,6 +8,7 @@
 #ifndef CS_IMAGE_H_
 #define CS_IMAGE_H_
 
+#include <functional>
 #include <vector>
 
 #include "llvm/StringRef.h"
@@ -37,18 +38,39 @@ class Image {
   }
 #endif
 
+  // Wraps externally owned data (e.g. a driver buffer) without copying it.
+  // The release function is called when the image is destroyed.  External
+  // images are never returned to the source's image pool and must not be
+  // resized.
+  Image(char* data, std::size_t size, std::function<void()> release)
+      : m_extData{data},
+        m_extSize{size},
+        m_extMat{1, static_cast<int>(size), CV_8UC1, data},
+        m_release{std::move(release)} {}
+
+  ~Image() {
+    if (m_release) m_release();
+  }
+
   Image(const Image&) = delete;
   Image& operator=(const Image&) = delete;
 
   // Getters
   operator llvm::StringRef() const { return str(); }
   llvm::StringRef str() const { return llvm::StringRef(data(), size()); }
-  std::size_t capacity() const { return m_data.capacity(); }
+  std::size_t capacity() const {
+    return m_extData ? m_extSize : m_data.capacity();
+  }
   const char* data() const {
+    if (m_extData) return m_extData;
     return reinterpret_cast<const char*>(m_data.data());
   }
-  char* data() { return reinterpret_cast<char*>(m_data.data()); }
-  std::size_t size() const { return m_data.size(); }
+  char* data() {
+    if (m_extData) return m_extData;
+    return reinterpret_cast<char*>(m_data.data());
+  }
+  std::size_t size() const { return m_extData ? m_extSize : m_data.size(); }
+  bool IsExternal() const { return m_extData != nullptr; }
 
   const std::vector<uchar>& vec() const { return m_data; }
   std::vector<uchar>& vec() { return m_data; }
@@ -72,10 +94,13 @@ class Image {
         type = CV_8UC1;
         break;
     }
-    return cv::Mat{height, width, type, m_data.data()};
+    return cv::Mat{height, width, type, data()};
   }
 
-  cv::_InputArray AsInputArray() { return cv::_InputArray{m_data}; }
+  cv::_InputArray AsInputArray() {
+    if (m_extData) return cv::_InputArray{m_extMat};
+    return cv::_InputArray{m_data};
+  }
 
   bool Is(int width_, int height_) {
     return width == width_ && height == height_;
@@ -95,6 +120,12 @@ class Image {
  private:
   std::vector<uchar> m_data;
 
+  // External data (if m_extData is non-null)
+  char* m_extData{nullptr};
+  std::size_t m_extSize{0};
+  cv::Mat m_extMat;
+  std::function<void()> m_release;
+
  public:
   VideoMode::PixelFormat pixelFormat{VideoMode::kUnknown};
   int width{0};
@@ -75,6 +75,7 @@ class MjpegServerImpl::ConnThread : public wpi::SafeThread {
 
   std::unique_ptr<wpi::NetworkStream> m_stream;
   std::shared_ptr<SourceImpl> m_source;
+  int m_priority = 0;
   bool m_streaming = false;
   bool m_noStreaming = false;
 
@@ -88,6 +89,11 @@ class MjpegServerImpl::ConnThread : public wpi::SafeThread {
     return m_source;
   }
 
+  int GetPriority() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_priority;
+  }
+
   void StartStream() {
     std::lock_guard<std::mutex> lock(m_mutex);
     m_source->EnableSink();
@@ -518,31 +524,59 @@ void MjpegServerImpl::ConnThread::SendStream(wpi::raw_socket_ostream& os) {
   SDEBUG("Headers send, sending stream now");
 
   StartStream();
+  std::shared_ptr<SourceImpl> lastSource;
+  uint64_t lastSequence = 0;
+  Frame::Time lastFrameTime = 0;
   while (m_active && !os.has_error()) {
     auto source = GetSource();
+    // Sequence numbers are per-source
+    if (source != lastSource) {
+      // Have the source start our conversion as soon as each frame arrives
+      if (lastSource)
+        lastSource->RemoveConversionHint(m_width, m_height, VideoMode::kMJPEG,
+                                         m_compression);
+      if (source)
+        source->AddConversionHint(m_width, m_height, VideoMode::kMJPEG,
+                                  m_compression);
+      lastSource = source;
+      lastSequence = 0;
+    }
     if (!source) {
-      // Source disconnected; sleep for one second
-      std::this_thread::sleep_for(std::chrono::seconds(1));
+      // Source disconnected; wait (up to one second) for a new one
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait_for(lock, std::chrono::seconds(1),
+                      [=] { return !m_active || m_source; });
       continue;
     }
     SDEBUG4("waiting for frame");
-    Frame frame = source->GetNextFrame();  // blocks
+    // Bounded wait so a stalled source doesn't block noticing that the
+    // connection or source changed.
+    CS_Status status = 0;
+    Frame frame =
+        source->GetNextFrame(lastSequence, 0.5, &status, GetPriority());
     if (!m_active) break;
-    if (!frame) {
-      // Bad frame; sleep for 20 ms so we don't consume all processor time.
-      std::this_thread::sleep_for(std::chrono::milliseconds(20));
-      continue;
+    if (status == CS_TIMED_OUT) continue;
+    lastSequence = frame.GetSequence();
+    // Frames are waited for by sequence number, so a bad frame doesn't
+    // cause a busy loop.
+    if (!frame) continue;
+
+    // Limit to the client-requested frame rate (allowing 10% early for
+    // jitter); skipped frames are never converted for this client.
+    if (m_fps > 0) {
+      Frame::Time frameTime = frame.GetTime();
+      Frame::Time minInterval = 10000000 / m_fps;
+      if (lastFrameTime != 0 && frameTime > lastFrameTime &&
+          frameTime - lastFrameTime < minInterval - minInterval / 10)
+        continue;
+      lastFrameTime = frameTime;
     }
 
     int width = m_width != 0 ? m_width : frame.GetOriginalWidth();
     int height = m_height != 0 ? m_height : frame.GetOriginalHeight();
     Image* image =
         frame.GetImage(width, height, VideoMode::kMJPEG, m_compression);
-    if (!image) {
-      // Shouldn't happen, but just in case...
-      std::this_thread::sleep_for(std::chrono::milliseconds(20));
-      continue;
-    }
+    if (!image) continue;  // shouldn't happen, but just in case...
 
     const char* data = image->data();
     std::size_t size = image->size();
@@ -557,8 +591,7 @@ void MjpegServerImpl::ConnThread::SendStream(wpi::raw_socket_ostream& os) {
       case VideoMode::kYUYV:
       case VideoMode::kRGB565:
       default:
-        // Bad frame; sleep for 10 ms so we don't consume all processor time.
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // Bad frame; just wait for the next one.
         continue;
     }
 
@@ -567,6 +600,7 @@ void MjpegServerImpl::ConnThread::SendStream(wpi::raw_socket_ostream& os) {
     // print the individual mimetype and the length
     // sending the content-length fixes random stream disruption observed
     // with firefox
+    // frame time is the capture time (when known)
     double timestamp = frame.GetTime() / 10000000.0;
     header.clear();
     oss << "\r\n--" BOUNDARY "\r\n"
@@ -585,6 +619,9 @@ void MjpegServerImpl::ConnThread::SendStream(wpi::raw_socket_ostream& os) {
     }
     // os.flush();
   }
+  if (lastSource)
+    lastSource->RemoveConversionHint(m_width, m_height, VideoMode::kMJPEG,
+                                     m_compression);
   StopStream();
 }
 
@@ -763,6 +800,7 @@ void MjpegServerImpl::ServerThreadMain() {
     auto thr = it->GetThread();
     thr->m_stream = std::move(stream);
     thr->m_source = source;
+    thr->m_priority = GetPriority();
     thr->m_noStreaming = nstreams >= 10;
     thr->m_cond.notify_one();
   }
@@ -779,11 +817,19 @@ void MjpegServerImpl::SetSourceImpl(std::shared_ptr<SourceImpl> source) {
         if (thr->m_source && streaming) thr->m_source->DisableSink();
         thr->m_source = source;
         if (source && streaming) thr->m_source->EnableSink();
+        thr->m_cond.notify_one();
       }
     }
   }
 }
 
+void MjpegServerImpl::SetPriorityImpl(int priority) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto& connThread : m_connThreads) {
+    if (auto thr = connThread.GetThread()) thr->m_priority = priority;
+  }
+}
+
 namespace cs {
 
 CS_Sink CreateMjpegServer(llvm::StringRef name, llvm::StringRef listenAddress,
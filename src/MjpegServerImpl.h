@@ -40,6 +40,7 @@ class MjpegServerImpl : public SinkImpl {
 
  private:
   void SetSourceImpl(std::shared_ptr<SourceImpl> source) override;
+  void SetPriorityImpl(int priority) override;
 
   void ServerThreadMain();
 
@@ -225,3 +225,23 @@ void Notifier::NotifyNetworkInterfacesChanged() {
   thr->m_notifications.emplace(RawEvent::kNetworkInterfacesChanged);
   thr->m_cond.notify_one();
 }
+
+void Notifier::NotifySourceFramesDropped(const SourceImpl& source,
+                                         int count) {
+  auto thr = m_owner.GetThread();
+  if (!thr) return;
+
+  auto handleData = Sources::GetInstance().Find(source);
+
+  thr->m_notifications.emplace(source.GetName(), handleData.first,
+                               RawEvent::kSourceFramesDropped, count);
+  thr->m_cond.notify_one();
+}
+
+void Notifier::NotifyUsbCamerasChanged() {
+  auto thr = m_owner.GetThread();
+  if (!thr) return;
+
+  thr->m_notifications.emplace(RawEvent::kUsbCamerasChanged);
+  thr->m_cond.notify_one();
+}
@@ -54,6 +54,8 @@ class Notifier {
   void NotifySinkSourceChanged(llvm::StringRef name, CS_Sink sink,
                                CS_Source source);
   void NotifyNetworkInterfacesChanged();
+  void NotifyUsbCamerasChanged();
+  void NotifySourceFramesDropped(const SourceImpl& source, int count);
 
  private:
   Notifier();
@@ -7,6 +7,13 @@
 
 #include "SinkImpl.h"
 
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 #include "Notifier.h"
 #include "SourceImpl.h"
 
@@ -16,9 +23,13 @@ SinkImpl::SinkImpl(llvm::StringRef name) : m_name{name} {}
 
 SinkImpl::~SinkImpl() {
   if (m_source) {
+    if (m_eventFd >= 0) m_source->RemoveFrameEventFd(m_eventFd);
     if (m_enabledCount > 0) m_source->DisableSink();
     m_source->RemoveSink();
   }
+#ifdef __linux__
+  if (m_eventFd >= 0) ::close(m_eventFd);
+#endif
 }
 
 void SinkImpl::SetDescription(llvm::StringRef description) {
@@ -38,6 +49,7 @@ void SinkImpl::Enable() {
   ++m_enabledCount;
   if (m_enabledCount == 1) {
     if (m_source) m_source->EnableSink();
+    SetEnabledImpl(true);
     Notifier::GetInstance().NotifySink(*this, CS_SINK_ENABLED);
   }
 }
@@ -47,6 +59,7 @@ void SinkImpl::Disable() {
   --m_enabledCount;
   if (m_enabledCount == 0) {
     if (m_source) m_source->DisableSink();
+    SetEnabledImpl(false);
     Notifier::GetInstance().NotifySink(*this, CS_SINK_DISABLED);
   }
 }
@@ -56,10 +69,12 @@ void SinkImpl::SetEnabled(bool enabled) {
   if (enabled && m_enabledCount == 0) {
     if (m_source) m_source->EnableSink();
     m_enabledCount = 1;
+    SetEnabledImpl(true);
     Notifier::GetInstance().NotifySink(*this, CS_SINK_ENABLED);
   } else if (!enabled && m_enabledCount > 0) {
     if (m_source) m_source->DisableSink();
     m_enabledCount = 0;
+    SetEnabledImpl(false);
     Notifier::GetInstance().NotifySink(*this, CS_SINK_DISABLED);
   }
 }
@@ -69,6 +84,7 @@ void SinkImpl::SetSource(std::shared_ptr<SourceImpl> source) {
     std::lock_guard<std::mutex> lock(m_mutex);
     if (m_source == source) return;
     if (m_source) {
+      if (m_eventFd >= 0) m_source->RemoveFrameEventFd(m_eventFd);
       if (m_enabledCount > 0) m_source->DisableSink();
       m_source->RemoveSink();
     }
@@ -76,11 +92,38 @@ void SinkImpl::SetSource(std::shared_ptr<SourceImpl> source) {
     if (m_source) {
       m_source->AddSink();
       if (m_enabledCount > 0) m_source->EnableSink();
+      if (m_eventFd >= 0) m_source->AddFrameEventFd(m_eventFd);
     }
   }
+  m_sourceCv.notify_all();
   SetSourceImpl(source);
 }
 
+std::shared_ptr<SourceImpl> SinkImpl::WaitForSource(double timeout) const {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_sourceCv.wait_for(lock, std::chrono::duration<double>(timeout),
+                      [=] { return static_cast<bool>(m_source); });
+  return m_source;
+}
+
+int SinkImpl::GetEventFd() {
+#ifdef __linux__
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_eventFd < 0) {
+    m_eventFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_eventFd >= 0 && m_source) m_source->AddFrameEventFd(m_eventFd);
+  }
+  return m_eventFd;
+#else
+  return -1;
+#endif
+}
+
+void SinkImpl::SetPriority(int priority) {
+  m_priority = priority;
+  SetPriorityImpl(priority);
+}
+
 std::string SinkImpl::GetError() const {
   std::lock_guard<std::mutex> lock(m_mutex);
   if (!m_source) return "no source connected";
@@ -98,3 +141,7 @@ llvm::StringRef SinkImpl::GetError(llvm::SmallVectorImpl<char>& buf) const {
 }
 
 void SinkImpl::SetSourceImpl(std::shared_ptr<SourceImpl> source) {}
+
+void SinkImpl::SetPriorityImpl(int priority) {}
+
+void SinkImpl::SetEnabledImpl(bool enabled) {}
@@ -8,6 +8,8 @@
 #ifndef CS_SINKIMPL_H_
 #define CS_SINKIMPL_H_
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -43,11 +45,29 @@ class SinkImpl {
     return m_source;
   }
 
-  std::string GetError() const;
-  llvm::StringRef GetError(llvm::SmallVectorImpl<char>& buf) const;
+  // Waits up to timeout seconds for a source to be connected.  Returns the
+  // source, or nullptr if none was connected before the timeout.
+  std::shared_ptr<SourceImpl> WaitForSource(double timeout) const;
+
+  // Gets an eventfd that becomes readable each time the connected source
+  // has a new frame (or error).  The fd is created on first use, is owned by
+  // the sink, and follows the sink across SetSource() calls.  Returns -1 if
+  // not supported on this platform.
+  int GetEventFd();
+
+  // Sets/gets the sink priority.  When a new frame arrives, higher priority
+  // sinks are woken first.  Defaults to 0.
+  void SetPriority(int priority);
+  int GetPriority() const { return m_priority; }
+
+  virtual std::string GetError() const;
+  virtual llvm::StringRef GetError(llvm::SmallVectorImpl<char>& buf) const;
 
  protected:
   virtual void SetSourceImpl(std::shared_ptr<SourceImpl> source);
+  virtual void SetPriorityImpl(int priority);
+  // Called when the sink is enabled or disabled, with m_mutex held.
+  virtual void SetEnabledImpl(bool enabled);
 
   mutable std::mutex m_mutex;
 
@@ -55,7 +75,10 @@ class SinkImpl {
   std::string m_name;
   std::string m_description;
   std::shared_ptr<SourceImpl> m_source;
+  mutable std::condition_variable m_sourceCv;
   int m_enabledCount{0};
+  int m_eventFd{-1};
+  std::atomic_int m_priority{0};
 };
 
 }  // namespace cs
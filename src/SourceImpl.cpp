@@ -8,10 +8,17 @@
 #include "SourceImpl.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
 #include "llvm/STLExtras.h"
+#include "support/timestamp.h"
 
+#include "FrameConverter.h"
 #include "Log.h"
 #include "Notifier.h"
 
@@ -19,14 +26,37 @@ using namespace cs;
 
 static constexpr std::size_t kMaxImagesAvail = 32;
 
+// Maximum time lower priority sinks are held off waiting for higher priority
+// sinks to take a frame.
+static constexpr std::chrono::milliseconds kMaxFrameDefer{50};
+
+// How long a reduced demand must persist before auto video mode switches to
+// a cheaper mode.
+static constexpr std::chrono::seconds kAutoVideoModeHoldTime{5};
+
+// Maximum age (in Frame::Time units) of a frame handed to a new waiter
+// without waiting for the next one.
+static constexpr uint64_t kRecentFrameAge = 10000000;
+
 SourceImpl::SourceImpl(llvm::StringRef name) : m_name{name} {
   m_frame = Frame{*this, llvm::StringRef{}, 0};
 }
 
 SourceImpl::~SourceImpl() {
+  // Eager conversions reference this source through their frames.  At exit
+  // the converter may already be gone (its queue was cleared then).
+  if (!FrameConverter::destroyed()) FrameConverter::GetInstance().Cancel(*this);
   // Wake up anyone who is waiting.  This also clears the current frame,
   // which is good because its destructor will call back into the class.
   Wakeup();
+  {
+    std::lock_guard<std::mutex> lock{m_frameMutex};
+    m_frameRing.clear();
+    for (auto queue : m_frameQueues) {
+      std::lock_guard<std::mutex> queueLock{queue->mutex};
+      queue->frames.clear();
+    }
+  }
   // Set a flag so ReleaseFrame() doesn't re-add them to m_framesAvail.
   // Put in a block so we destroy before the destructor ends.
   {
@@ -66,19 +96,443 @@ Frame SourceImpl::GetCurFrame() {
   return m_frame;
 }
 
-Frame SourceImpl::GetNextFrame() {
+uint64_t SourceImpl::GetCurFrameSequence() {
+  std::unique_lock<std::mutex> lock{m_frameMutex};
+  return m_frameSeq;
+}
+
+Frame SourceImpl::GetNextFrame(int priority) {
+  std::unique_lock<std::mutex> lock{m_frameMutex};
+  auto oldSeq = m_frameSeq;
+  auto oldWakeupCount = m_wakeupCount;
+  WaitForFrame(lock, priority, -1, [=] {
+    return m_frameSeq != oldSeq || m_wakeupCount != oldWakeupCount;
+  });
+  return m_frame;
+}
+
+Frame SourceImpl::GetNextFrame(uint64_t seq, double timeout,
+                               CS_Status* status, int priority) {
   std::unique_lock<std::mutex> lock{m_frameMutex};
-  auto oldTime = m_frame.GetTime();
-  m_frameCv.wait(lock, [=] { return m_frame.GetTime() != oldTime; });
+  if (seq == 0) {
+    if (IsCurFrameRecent()) return m_frame;
+    seq = m_frameSeq;
+  }
+  auto oldWakeupCount = m_wakeupCount;
+  if (!WaitForFrame(lock, priority, timeout, [=] {
+        return m_frameSeq > seq || m_wakeupCount != oldWakeupCount;
+      })) {
+    *status = CS_TIMED_OUT;
+    return Frame{};
+  }
   return m_frame;
 }
 
-void SourceImpl::Wakeup() {
+Frame SourceImpl::GetNextFrame(uint64_t seq, uint64_t* skipped,
+                               int priority) {
+  std::unique_lock<std::mutex> lock{m_frameMutex};
+  if (skipped) *skipped = 0;
+  if (seq == 0) {
+    if (IsCurFrameRecent()) return m_frame;
+    seq = m_frameSeq;
+  }
+  auto oldWakeupCount = m_wakeupCount;
+  WaitForFrame(lock, priority, -1, [=] {
+    return m_frameSeq > seq || m_wakeupCount != oldWakeupCount;
+  });
+  // woken up without a new frame
+  if (m_frameSeq <= seq) return m_frame;
+
+  uint64_t oldest = m_frameSeq - m_frameRing.size() + 1;
+  uint64_t want = seq + 1;
+  if (want < oldest) {
+    if (skipped) *skipped = oldest - want;
+    want = oldest;
+  }
+  return m_frameRing[want - oldest];
+}
+
+bool SourceImpl::IsRecentFrame(const Frame& frame) {
+  if (!frame) return false;
+  auto now = wpi::Now();
+  auto time = frame.GetTime();
+  return time <= now && now - time <= kRecentFrameAge;
+}
+
+bool SourceImpl::IsCurFrameRecent() const { return IsRecentFrame(m_frame); }
+
+bool SourceImpl::WaitForFrame(std::unique_lock<std::mutex>& lock,
+                              int priority, double timeout,
+                              std::function<bool()> ready) {
+  // Insert into the waiter list, which is kept in priority order (highest
+  // first, FIFO within the same priority).
+  FrameWaiter waiter{priority};
+  auto it = std::find_if(
+      m_frameWaiters.begin(), m_frameWaiters.end(),
+      [=](const FrameWaiter* w) { return w->priority < priority; });
+  m_frameWaiters.insert(it, &waiter);
+
+  auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::duration<double>(timeout < 0 ? 0 : timeout));
+
+  bool gotFrame = true;
+  for (;;) {
+    if (ready()) {
+      // Lower priority waiters hold off until the higher priority waiters
+      // have taken the frame (or the deferral period has expired).  The
+      // caller's own timeout still bounds the wait.
+      auto now = std::chrono::steady_clock::now();
+      if (m_deferPending == 0 || priority >= m_deferPriority ||
+          now >= m_deferDeadline || (timeout >= 0 && now >= deadline))
+        break;
+      waiter.cv.wait_until(lock, (timeout >= 0 && deadline < m_deferDeadline)
+                                     ? deadline
+                                     : m_deferDeadline);
+      continue;
+    }
+    if (timeout < 0) {
+      waiter.cv.wait(lock);
+      continue;
+    }
+    if (std::chrono::steady_clock::now() >= deadline) {
+      gotFrame = false;
+      break;
+    }
+    waiter.cv.wait_until(lock, deadline);
+  }
+
+  m_frameWaiters.erase(
+      std::find(m_frameWaiters.begin(), m_frameWaiters.end(), &waiter));
+
+  // Release deferred waiters once all of the high priority waiters are done
+  if (waiter.deferCounted && m_deferPending > 0 && --m_deferPending == 0) {
+    for (auto w : m_frameWaiters) w->cv.notify_one();
+  }
+  return gotFrame;
+}
+
+void SourceImpl::NotifyFrameWaiters() {
+  m_deferPending = 0;
+  for (auto w : m_frameWaiters) w->deferCounted = false;
+  if (m_deferLowPriority && !m_frameWaiters.empty() &&
+      m_frameWaiters.front()->priority > m_frameWaiters.back()->priority) {
+    m_deferPriority = m_frameWaiters.front()->priority;
+    m_deferDeadline = std::chrono::steady_clock::now() + kMaxFrameDefer;
+    for (auto w : m_frameWaiters) {
+      if (w->priority != m_deferPriority) break;
+      w->deferCounted = true;
+      ++m_deferPending;
+    }
+  }
+
+  // Wake everyone in priority order.  Deferred waiters go back to waiting
+  // until the high priority waiters are done or m_deferDeadline passes (see
+  // WaitForFrame()); a high priority waiter this frame doesn't satisfy
+  // (e.g. an every-Nth queue still empty) must not hold them off longer.
+  for (auto w : m_frameWaiters) w->cv.notify_one();
+}
+
+Frame SourceImpl::GetFrameNearTime(Frame::Time time, uint64_t afterSequence) {
+  std::unique_lock<std::mutex> lock{m_frameMutex};
+  const Frame* nearest = nullptr;
+  Frame::Time nearestDelta = 0;
+  for (const auto& frame : m_frameRing) {
+    if (!frame || frame.GetSequence() <= afterSequence) continue;
+    Frame::Time frameTime = frame.GetTime();
+    Frame::Time delta = frameTime > time ? frameTime - time : time - frameTime;
+    if (!nearest || delta < nearestDelta) {
+      nearest = &frame;
+      nearestDelta = delta;
+    }
+  }
+  if (!nearest) return Frame{};
+  return *nearest;
+}
+
+void SourceImpl::SetFrameRingSize(int size) {
+  if (size < 1) size = 1;
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  m_frameRingSize = size;
+  while (m_frameRing.size() > m_frameRingSize) m_frameRing.pop_front();
+}
+
+int SourceImpl::GetFrameRingSize() {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  return m_frameRingSize;
+}
+
+void SourceImpl::SetDeferLowPriority(bool defer) {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  m_deferLowPriority = defer;
+}
+
+bool SourceImpl::GetDeferLowPriority() {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  return m_deferLowPriority;
+}
+
+void SourceImpl::AddFrameEventFd(int fd) {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  m_frameEventFds.push_back(fd);
+}
+
+void SourceImpl::RemoveFrameEventFd(int fd) {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  m_frameEventFds.erase(
+      std::remove(m_frameEventFds.begin(), m_frameEventFds.end(), fd),
+      m_frameEventFds.end());
+}
+
+void SourceImpl::AddConversionHint(int width, int height,
+                                   VideoMode::PixelFormat pixelFormat,
+                                   int jpegQuality) {
+  {
+    std::lock_guard<std::mutex> lock{m_frameMutex};
+    for (auto& hint : m_conversionHints) {
+      if (hint.width == width && hint.height == height &&
+          hint.pixelFormat == pixelFormat && hint.jpegQuality == jpegQuality) {
+        ++hint.refcount;
+        return;
+      }
+    }
+    m_conversionHints.emplace_back(
+        ConversionHint{width, height, pixelFormat, jpegQuality, 1});
+  }
+  ConversionHintsChanged();
+}
+
+void SourceImpl::RemoveConversionHint(int width, int height,
+                                      VideoMode::PixelFormat pixelFormat,
+                                      int jpegQuality) {
   {
     std::lock_guard<std::mutex> lock{m_frameMutex};
-    m_frame = Frame{*this, llvm::StringRef{}, 0};
+    auto it = std::find_if(
+        m_conversionHints.begin(), m_conversionHints.end(),
+        [&](const ConversionHint& hint) {
+          return hint.width == width && hint.height == height &&
+                 hint.pixelFormat == pixelFormat &&
+                 hint.jpegQuality == jpegQuality;
+        });
+    if (it == m_conversionHints.end() || --it->refcount > 0) return;
+    m_conversionHints.erase(it);
+  }
+  ConversionHintsChanged();
+}
+
+void SourceImpl::SetMaxFPS(double fps) {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  // frame times are in 100 ns units
+  m_minFrameInterval = fps > 0 ? static_cast<Frame::Time>(10000000.0 / fps) : 0;
+}
+
+double SourceImpl::GetMaxFPS() {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  if (m_minFrameInterval == 0) return 0;
+  return 10000000.0 / m_minFrameInterval;
+}
+
+void SourceImpl::SetDecimation(int decimation) {
+  if (decimation < 1) decimation = 1;
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  m_decimation = decimation;
+  m_decimationCount = 0;
+}
+
+int SourceImpl::GetDecimation() {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  return m_decimation;
+}
+
+bool SourceImpl::ShouldPublishFrame(Frame::Time time) {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  if (m_decimation > 1) {
+    if (++m_decimationCount < m_decimation) return false;
+    m_decimationCount = 0;
   }
-  m_frameCv.notify_all();
+  if (m_minFrameInterval != 0) {
+    // Allow 10% early so jitter in frame times doesn't cause every other
+    // frame to be dropped when the camera runs at a multiple of the limit.
+    if (m_lastPublishTime != 0 && time > m_lastPublishTime &&
+        time - m_lastPublishTime < m_minFrameInterval - m_minFrameInterval / 10)
+      return false;
+    m_lastPublishTime = time;
+  }
+  return true;
+}
+
+void SourceImpl::SetAutoVideoMode(bool enabled) {
+  VideoMode mode;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    mode = m_mode;
+  }
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  if (enabled && !m_autoMode) m_autoBaseMode = mode;
+  m_autoMode = enabled;
+  m_autoPendingMode = VideoMode{};
+}
+
+bool SourceImpl::GetAutoVideoMode() {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  return m_autoMode;
+}
+
+static bool IsSameMode(const VideoMode& a, const VideoMode& b) {
+  return a.pixelFormat == b.pixelFormat && a.width == b.width &&
+         a.height == b.height && a.fps == b.fps;
+}
+
+bool SourceImpl::CheckAutoVideoMode(VideoMode* mode) {
+  // Don't use GetVideoMode()/EnumerateVideoModes(); this is called from
+  // camera threads, which must not wait on property caching.
+  VideoMode curMode;
+  std::vector<VideoMode> videoModes;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    curMode = m_mode;
+    videoModes = m_videoModes;
+  }
+
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  if (!m_autoMode) return false;
+
+  // Aggregate demand.  Zero width/height hints want the full (base) size.
+  // Sinks only hint while enabled; without any enabled sinks (e.g. while
+  // lingering) or hints, fall back to the base mode.
+  const VideoMode& base = m_autoBaseMode;
+  int reqWidth = base.width;
+  int reqHeight = base.height;
+  int reqFormat = base.pixelFormat;
+  if (m_numSinksEnabled > 0 && !m_conversionHints.empty()) {
+    reqWidth = 0;
+    reqHeight = 0;
+    reqFormat = -1;
+    for (const auto& hint : m_conversionHints) {
+      reqWidth = std::max(reqWidth, hint.width == 0 ? base.width : hint.width);
+      reqHeight =
+          std::max(reqHeight, hint.height == 0 ? base.height : hint.height);
+      if (reqFormat == -1)
+        reqFormat = hint.pixelFormat;
+      else if (reqFormat != hint.pixelFormat)
+        reqFormat = VideoMode::kUnknown;  // mixed
+    }
+  }
+
+  // Pick the mode with the fewest pixels that is at least as large as the
+  // request (but no larger than the base mode) and at least as fast as the
+  // base mode.  Prefer the requested format (no conversion), then MJPEG
+  // (least bandwidth), then the base format.
+  auto formatRank = [&](int pixelFormat) {
+    if (pixelFormat == reqFormat) return 0;
+    if (pixelFormat == VideoMode::kMJPEG) return 1;
+    if (pixelFormat == base.pixelFormat) return 2;
+    return 3;
+  };
+  VideoMode desired = base;
+  bool found = false;
+  for (const auto& m : videoModes) {
+    if (m.width < reqWidth || m.height < reqHeight || m.width > base.width ||
+        m.height > base.height || m.fps < base.fps)
+      continue;
+    if (found) {
+      int pixels = m.width * m.height;
+      int bestPixels = desired.width * desired.height;
+      if (pixels > bestPixels) continue;
+      if (pixels == bestPixels) {
+        int rank = formatRank(m.pixelFormat);
+        int bestRank = formatRank(desired.pixelFormat);
+        if (rank > bestRank) continue;
+        if (rank == bestRank && m.fps >= desired.fps) continue;
+      }
+    }
+    desired = m;
+    found = true;
+  }
+
+  if (IsSameMode(desired, curMode)) {
+    m_autoPendingMode = VideoMode{};
+    return false;
+  }
+
+  // Apply increases immediately so sinks aren't starved of resolution.
+  // Hold off on reductions until the demand has been stable.
+  if (desired.width * desired.height <= curMode.width * curMode.height) {
+    auto now = std::chrono::steady_clock::now();
+    if (!IsSameMode(desired, m_autoPendingMode)) {
+      m_autoPendingMode = desired;
+      m_autoPendingSince = now;
+      return false;
+    }
+    if (now - m_autoPendingSince < kAutoVideoModeHoldTime) return false;
+  }
+
+  m_autoPendingMode = VideoMode{};
+  *mode = desired;
+  return true;
+}
+
+void SourceImpl::AddFrameSignal(FrameSignal* signal) {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  m_frameSignals.push_back(signal);
+}
+
+void SourceImpl::RemoveFrameSignal(FrameSignal* signal) {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  m_frameSignals.erase(
+      std::remove(m_frameSignals.begin(), m_frameSignals.end(), signal),
+      m_frameSignals.end());
+}
+
+void SourceImpl::SetFrameSignals() {
+  for (auto signal : m_frameSignals) {
+    {
+      std::lock_guard<std::mutex> signalLock{signal->mutex};
+      signal->signaled = true;
+    }
+    signal->cv.notify_all();
+  }
+}
+
+void SourceImpl::AddFrameQueue(FrameQueue* queue) {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  m_frameQueues.push_back(queue);
+}
+
+void SourceImpl::RemoveFrameQueue(FrameQueue* queue) {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  m_frameQueues.erase(
+      std::remove(m_frameQueues.begin(), m_frameQueues.end(), queue),
+      m_frameQueues.end());
+}
+
+Frame SourceImpl::GetQueuedFrame(FrameQueue& queue, double timeout,
+                                 CS_Status* status, int priority) {
+  std::unique_lock<std::mutex> lock{m_frameMutex};
+  auto oldWakeupCount = m_wakeupCount;
+  if (!WaitForFrame(lock, priority, timeout, [&] {
+        std::lock_guard<std::mutex> queueLock{queue.mutex};
+        return !queue.frames.empty() || m_wakeupCount != oldWakeupCount;
+      })) {
+    *status = CS_TIMED_OUT;
+    return Frame{};
+  }
+  std::lock_guard<std::mutex> queueLock{queue.mutex};
+  // woken up without a new frame
+  if (queue.frames.empty()) return m_frame;
+  Frame frame = std::move(queue.frames.front());
+  queue.frames.pop_front();
+  return frame;
+}
+
+void SourceImpl::Wakeup() {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  m_frame = Frame{*this, llvm::StringRef{}, 0};
+  ++m_wakeupCount;
+  m_deferPending = 0;
+  for (auto w : m_frameWaiters) w->cv.notify_one();
+  SetFrameSignals();
 }
 
 int SourceImpl::GetPropertyIndex(llvm::StringRef name) const {
@@ -146,6 +600,14 @@ int SourceImpl::GetProperty(int property, CS_Status* status) const {
   return prop->value;
 }
 
+void SourceImpl::SetProperties(llvm::ArrayRef<int> properties,
+                               llvm::ArrayRef<int> values, CS_Status* status) {
+  for (std::size_t i = 0; i < properties.size(); ++i) {
+    SetProperty(properties[i], values[i], status);
+    if (*status != CS_OK) return;
+  }
+}
+
 int SourceImpl::GetPropertyMin(int property, CS_Status* status) const {
   if (!m_properties_cached && !CacheProperties(status)) return 0;
   std::lock_guard<std::mutex> lock(m_mutex);
@@ -301,7 +763,11 @@ std::unique_ptr<Image> SourceImpl::AllocImage(
 }
 
 void SourceImpl::PutFrame(VideoMode::PixelFormat pixelFormat, int width,
-                          int height, llvm::StringRef data, Frame::Time time) {
+                          int height, llvm::StringRef data, Frame::Time time,
+                          Frame::Time dequeueTime, uint64_t captureSequence) {
+  // Drop frames over the rate limit before doing any work on them
+  if (!ShouldPublishFrame(time)) return;
+
   auto image = AllocImage(pixelFormat, width, height, data.size());
 
   // Copy in image data
@@ -310,29 +776,113 @@ void SourceImpl::PutFrame(VideoMode::PixelFormat pixelFormat, int width,
                              << " bytes)");
   std::memcpy(image->data(), data.data(), data.size());
 
-  PutFrame(std::move(image), time);
+  PutFrame(std::move(image), time, dequeueTime, captureSequence);
 }
 
-void SourceImpl::PutFrame(std::unique_ptr<Image> image, Frame::Time time) {
-  // Update frame
-  {
-    std::lock_guard<std::mutex> lock{m_frameMutex};
-    m_frame = Frame{*this, std::move(image), time};
-  }
+void SourceImpl::PutFrame(std::unique_ptr<Image> image, Frame::Time time,
+                          Frame::Time dequeueTime, uint64_t captureSequence) {
+  Frame frame{*this, std::move(image), time};
+  if (dequeueTime != 0) frame.m_impl->dequeueTime = dequeueTime;
+  frame.m_impl->captureSequence = captureSequence;
 
-  // Signal listeners
-  m_frameCv.notify_all();
+  // Update frame and signal listeners
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  PublishFrame(std::move(frame));
+  NotifyFrameWaiters();
 }
 
 void SourceImpl::PutError(llvm::StringRef msg, Frame::Time time) {
-  // Update frame
-  {
-    std::lock_guard<std::mutex> lock{m_frameMutex};
-    m_frame = Frame{*this, msg, time};
+  // Update frame and signal listeners
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  PublishFrame(Frame{*this, msg, time});
+  NotifyFrameWaiters();
+}
+
+void SourceImpl::CopyExternalFrames() {
+  std::lock_guard<std::mutex> lock{m_frameMutex};
+  // The current frame is usually also the newest frame in the ring; copy it
+  // only once
+  bool curCopied = false;
+  for (auto& frame : m_frameRing) {
+    bool isCur = frame.m_impl == m_frame.m_impl;
+    frame = CopyExternalFrame(frame);
+    if (isCur && !curCopied) {
+      m_frame = frame;
+      curCopied = true;
+    }
+  }
+  if (!curCopied) m_frame = CopyExternalFrame(m_frame);
+
+  for (auto queue : m_frameQueues) {
+    std::lock_guard<std::mutex> queueLock{queue->mutex};
+    for (auto& frame : queue->frames) frame = CopyExternalFrame(frame);
+  }
+}
+
+Frame SourceImpl::CopyExternalFrame(const Frame& frame) {
+  if (!frame) return frame;
+  auto impl = frame.m_impl;
+  std::lock_guard<std::recursive_mutex> lock(impl->mutex);
+  if (std::none_of(impl->images.begin(), impl->images.end(),
+                   [](const Image* image) { return image->IsExternal(); }))
+    return frame;
+
+  Frame copy;
+  for (auto image : impl->images) {
+    auto newImage = AllocImage(image->pixelFormat, image->width,
+                               image->height, image->size());
+    std::memcpy(newImage->data(), image->data(), image->size());
+    if (!copy)
+      copy = Frame{*this, std::move(newImage), impl->time};
+    else
+      copy.m_impl->images.push_back(newImage.release());
+  }
+  copy.m_impl->sequence = impl->sequence;
+  copy.m_impl->captureSequence = impl->captureSequence;
+  copy.m_impl->dequeueTime = impl->dequeueTime;
+  copy.m_impl->publishTime = impl->publishTime;
+  return copy;
+}
+
+void SourceImpl::PublishFrame(Frame frame) {
+  frame.m_impl->sequence = ++m_frameSeq;
+  frame.m_impl->publishTime = wpi::Now();
+  m_frameRing.push_back(frame);
+  while (m_frameRing.size() > m_frameRingSize) m_frameRing.pop_front();
+  m_frame = std::move(frame);
+
+  // Start hinted conversions
+  if (m_frame && !FrameConverter::destroyed()) {
+    for (const auto& hint : m_conversionHints)
+      FrameConverter::GetInstance().Convert(m_frame, hint.width, hint.height,
+                                            hint.pixelFormat,
+                                            hint.jpegQuality);
+  }
+
+  // Fill sink frame queues
+  for (auto queue : m_frameQueues) {
+    std::lock_guard<std::mutex> queueLock{queue->mutex};
+    if (++queue->count < queue->every) continue;
+    queue->count = 0;
+    queue->frames.push_back(m_frame);
+    while (queue->frames.size() > queue->depth) {
+      queue->frames.pop_front();
+      ++queue->dropped;
+    }
+  }
+
+#ifdef __linux__
+  // Signal sink eventfds.  These are nonblocking, so this can't stall the
+  // source; if a counter would overflow, the fd is already readable anyway.
+  uint64_t one = 1;
+  for (int fd : m_frameEventFds) {
+    if (::write(fd, &one, sizeof(one)) < 0) {
+      // ignore errors
+    }
   }
+#endif
 
-  // Signal listeners
-  m_frameCv.notify_all();
+  SetFrameSignals();
 }
 
 void SourceImpl::NotifyPropertyCreated(int propIndex, PropertyImpl& prop) {
@@ -365,6 +915,8 @@ void SourceImpl::UpdatePropertyValue(int property, bool setString, int value,
 }
 
 void SourceImpl::ReleaseImage(std::unique_ptr<Image> image) {
+  // External images hand their data back to the owner when destroyed.
+  if (image->IsExternal()) return;
   std::lock_guard<std::mutex> lock{m_poolMutex};
   if (m_destroyFrames) return;
   // Return the frame to the pool.  First try to find an empty slot, otherwise
@@ -9,8 +9,11 @@
 #define CS_SOURCEIMPL_H_
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -79,12 +82,136 @@ class SourceImpl {
   // Gets the current frame (without waiting for a new one).
   Frame GetCurFrame();
 
+  // Returns true if frame is valid and recent enough to hand to a sink that
+  // starts (or resumes) grabbing, rather than waiting for the next frame.
+  static bool IsRecentFrame(const Frame& frame);
+
+  // Gets the sequence number of the most recent frame.  Every frame (or
+  // error) put by the source is assigned the next sequence number, starting
+  // at 1.
+  uint64_t GetCurFrameSequence();
+
   // Blocking function that waits for the next frame and returns it.
-  Frame GetNextFrame();
+  //
+  // All of the GetNextFrame() functions take the priority of the waiting
+  // sink.  Waiters are woken in priority order (highest first), and if
+  // SetDeferLowPriority(true) has been called, lower priority waiters are
+  // held off (for a bounded time) until the highest priority waiters have
+  // taken the frame.
+  Frame GetNextFrame(int priority = 0);
+
+  // Waits at most timeout seconds for a frame with a sequence number greater
+  // than seq and returns the most recent frame.  If seq is 0 and the current
+  // frame is recent, it is returned right away; otherwise waits for the next
+  // frame.  Returns immediately if such a frame is already available.  On
+  // timeout, sets status to CS_TIMED_OUT and returns an empty frame.
+  Frame GetNextFrame(uint64_t seq, double timeout, CS_Status* status,
+                     int priority = 0);
+
+  // Blocking function that waits for a frame with a sequence number greater
+  // than seq and returns the oldest such frame still held in the frame ring.
+  // If seq is 0, returns the current frame if it is recent, otherwise waits
+  // for the next frame.  If any
+  // frames after seq have already been pushed out of the ring, skipped is
+  // set to the number of frames lost; otherwise it is set to 0.
+  Frame GetNextFrame(uint64_t seq, uint64_t* skipped, int priority = 0);
+
+  // Gets the frame in the frame ring with the time closest to the given time
+  // (without waiting).  Error frames and frames with a sequence number not
+  // after afterSequence are ignored.  Returns an empty frame if there are no
+  // frames available.
+  Frame GetFrameNearTime(Frame::Time time, uint64_t afterSequence = 0);
+
+  // Sets/gets the number of recent frames retained in the frame ring.
+  // The minimum (and default) is 1.
+  void SetFrameRingSize(int size);
+  int GetFrameRingSize();
+
+  // Sets/gets whether lower priority sinks are held off until the highest
+  // priority sinks have taken each new frame.  Defaults to false.
+  void SetDeferLowPriority(bool defer);
+  bool GetDeferLowPriority();
 
   // Force a wakeup of all GetNextFrame() callers by sending an empty frame.
   void Wakeup();
 
+  // Add/remove an eventfd that is signaled (incremented) each time a new
+  // frame or error is put.
+  void AddFrameEventFd(int fd);
+  void RemoveFrameEventFd(int fd);
+
+  // A per-sink queue of frames, filled by the source as frames are put.
+  // Used to implement sink delivery modes other than latest-only.
+  struct FrameQueue {
+    std::mutex mutex;
+    // Maximum number of queued frames; the oldest frame is dropped on
+    // overflow.
+    std::size_t depth{1};
+    // Only every Nth frame is queued.
+    int every{1};
+    int count{0};
+    std::deque<Frame> frames;
+    // Number of frames dropped on overflow.
+    uint64_t dropped{0};
+  };
+
+  // A signal set each time a frame is put (or the source is woken up).  One
+  // signal can be added to several sources to wait for a frame from any of
+  // them.
+  struct FrameSignal {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool signaled{false};
+  };
+
+  // Add/remove a frame signal.  The signal must be removed before it is
+  // destroyed.
+  void AddFrameSignal(FrameSignal* signal);
+  void RemoveFrameSignal(FrameSignal* signal);
+
+  // Add/remove a conversion hint: an image format a sink will request from
+  // every frame.  Hinted conversions are started by a worker pool as soon as
+  // each frame is put.  A width/height of 0 means the original frame size.
+  // Hints are reference counted, so each add must be matched by a remove.
+  // Sinks should only hint while enabled, as auto video mode selection
+  // treats hints as demand.
+  void AddConversionHint(int width, int height,
+                         VideoMode::PixelFormat pixelFormat, int jpegQuality);
+  void RemoveConversionHint(int width, int height,
+                            VideoMode::PixelFormat pixelFormat,
+                            int jpegQuality);
+
+  // Sets/gets the maximum rate (in frames per second) at which frames are
+  // published; 0 (the default) means no limit.  Frames over the limit are
+  // dropped in PutFrame() before any copy or conversion.
+  void SetMaxFPS(double fps);
+  double GetMaxFPS();
+
+  // Sets/gets the decimation factor: only every Nth frame put is published.
+  // Defaults to 1 (every frame).
+  void SetDecimation(int decimation);
+  int GetDecimation();
+
+  // Enables/disables automatic video mode selection.  While enabled, the
+  // source picks the cheapest video mode that satisfies the largest image
+  // requested through conversion hints, bounded by the mode set at the time
+  // auto mode was enabled.  Mode reductions are only applied after the
+  // demand has been stable for a while, so reconnecting sinks don't cause
+  // the camera to switch modes back and forth.
+  void SetAutoVideoMode(bool enabled);
+  bool GetAutoVideoMode();
+
+  // Add/remove a frame queue.  The queue must be removed before it is
+  // destroyed.
+  void AddFrameQueue(FrameQueue* queue);
+  void RemoveFrameQueue(FrameQueue* queue);
+
+  // Waits at most timeout seconds (forever if negative) for a frame to be
+  // available in queue, and removes and returns it.  On timeout, sets status
+  // to CS_TIMED_OUT and returns an empty frame.
+  Frame GetQueuedFrame(FrameQueue& queue, double timeout, CS_Status* status,
+                       int priority = 0);
+
   // Property functions
   int GetPropertyIndex(llvm::StringRef name) const;
   llvm::ArrayRef<int> EnumerateProperties(llvm::SmallVectorImpl<int>& vec,
@@ -95,6 +222,10 @@ class SourceImpl {
                                   CS_Status* status) const;
   int GetProperty(int property, CS_Status* status) const;
   virtual void SetProperty(int property, int value, CS_Status* status) = 0;
+  // Sets several integer properties at once.  The default implementation
+  // sets them one at a time, stopping at the first error.
+  virtual void SetProperties(llvm::ArrayRef<int> properties,
+                             llvm::ArrayRef<int> values, CS_Status* status);
   int GetPropertyMin(int property, CS_Status* status) const;
   int GetPropertyMax(int property, CS_Status* status) const;
   int GetPropertyStep(int property, CS_Status* status) const;
@@ -134,14 +265,37 @@ class SourceImpl {
                                     int width, int height, std::size_t size);
 
  protected:
+  // time is the capture time.  If the frame was captured before it was
+  // received (e.g. by a V4L2 driver), dequeueTime is the time it was
+  // received and captureSequence is the driver's sequence number.
   void PutFrame(VideoMode::PixelFormat pixelFormat, int width, int height,
-                llvm::StringRef data, Frame::Time time);
-  void PutFrame(std::unique_ptr<Image> image, Frame::Time time);
+                llvm::StringRef data, Frame::Time time,
+                Frame::Time dequeueTime = 0, uint64_t captureSequence = 0);
+  void PutFrame(std::unique_ptr<Image> image, Frame::Time time,
+                Frame::Time dequeueTime = 0, uint64_t captureSequence = 0);
   void PutError(llvm::StringRef msg, Frame::Time time);
 
+  // Replaces frames held by the source (the current frame, the frame ring
+  // and sink frame queues) that reference external images with copies, so
+  // the external data (e.g. zero-copy driver buffers) can be released.
+  // Frames already taken by sinks are not affected.
+  void CopyExternalFrames();
+
+  // Returns true if a frame with the given time should be published, based
+  // on the rate limit and decimation.  Call once per frame, before
+  // PutFrame().  PutFrame() calls this itself when given raw data, so only
+  // callers that allocate an image themselves need to.
+  bool ShouldPublishFrame(Frame::Time time);
+
+  // Called periodically by camera threads.  Returns true (and sets mode) if
+  // auto mode is enabled and the video mode should be changed now.
+  bool CheckAutoVideoMode(VideoMode* mode);
+
   // Notification functions for corresponding atomics
   virtual void NumSinksChanged() = 0;
   virtual void NumSinksEnabledChanged() = 0;
+  // Called (without locks held) when the set of conversion hints changes.
+  virtual void ConversionHintsChanged() {}
 
   std::atomic_int m_numSinks{0};
   std::atomic_int m_numSinksEnabled{0};
@@ -190,18 +344,102 @@ class SourceImpl {
  private:
   void ReleaseImage(std::unique_ptr<Image> image);
   std::unique_ptr<Frame::Impl> AllocFrameImpl();
+  // Returns frame, or a copy of it if it references external images.
+  Frame CopyExternalFrame(const Frame& frame);
   void ReleaseFrameImpl(std::unique_ptr<Frame::Impl> data);
 
+  // Assigns the next sequence number and adds the frame to the frame ring;
+  // must be called with m_frameMutex held.
+  void PublishFrame(Frame frame);
+
+  // A thread waiting in GetNextFrame().
+  struct FrameWaiter {
+    explicit FrameWaiter(int priority_) : priority{priority_} {}
+    int priority;
+    // Whether the deferral of lower priority waiters is waiting on this one
+    bool deferCounted{false};
+    std::condition_variable cv;
+  };
+
+  // Returns true if m_frame is valid and recent enough to hand to a new
+  // waiter immediately.  lock must hold m_frameMutex.
+  bool IsCurFrameRecent() const;
+
+  // Waits until ready() returns true (honoring priority and deferral) or the
+  // timeout expires (a negative timeout waits forever).  Returns false on
+  // timeout.  lock must hold m_frameMutex.
+  bool WaitForFrame(std::unique_lock<std::mutex>& lock, int priority,
+                    double timeout, std::function<bool()> ready);
+
+  // Wakes frame waiters in priority order; must be called with m_frameMutex
+  // held after a new frame is published.
+  void NotifyFrameWaiters();
+  // Sets all frame signals.  Must be called with m_frameMutex held.
+  void SetFrameSignals();
+
   std::string m_name;
   std::string m_description;
 
   std::mutex m_frameMutex;
-  std::condition_variable m_frameCv;
 
   // Most recent frame (returned to callers of GetNextFrame)
   // Access protected by m_frameMutex.
   Frame m_frame;
 
+  // Recent frames, oldest first.  The newest frame has sequence number
+  // m_frameSeq, and the sequence numbers in the ring are contiguous.
+  // Access protected by m_frameMutex.
+  std::deque<Frame> m_frameRing;
+  std::size_t m_frameRingSize{1};
+  uint64_t m_frameSeq{0};
+  // Incremented by Wakeup() so sequence-based waiters also wake up.
+  uint64_t m_wakeupCount{0};
+
+  // Sink eventfds signaled on each new frame.
+  // Access protected by m_frameMutex.
+  std::vector<int> m_frameEventFds;
+
+  // Sink frame queues filled on each new frame.
+  // Access protected by m_frameMutex.
+  std::vector<FrameQueue*> m_frameQueues;
+
+  // Conversion hints, with reference counts.
+  // Access protected by m_frameMutex.
+  struct ConversionHint {
+    int width;
+    int height;
+    VideoMode::PixelFormat pixelFormat;
+    int jpegQuality;
+    int refcount;
+  };
+  std::vector<ConversionHint> m_conversionHints;
+
+  // Rate limit and decimation state.
+  // Access protected by m_frameMutex.
+  Frame::Time m_minFrameInterval{0};  // 0 for no limit
+  Frame::Time m_lastPublishTime{0};
+  int m_decimation{1};
+  int m_decimationCount{0};
+
+  // Auto video mode state.
+  // Access protected by m_frameMutex.
+  bool m_autoMode{false};
+  VideoMode m_autoBaseMode;  // mode when auto mode was enabled
+  VideoMode m_autoPendingMode;  // pending mode reduction
+  std::chrono::steady_clock::time_point m_autoPendingSince;
+
+  // Frame signals set on each new frame.
+  // Access protected by m_frameMutex.
+  std::vector<FrameSignal*> m_frameSignals;
+
+  // Threads waiting for frames, highest priority first.
+  // Access protected by m_frameMutex (as are the deferral variables).
+  std::vector<FrameWaiter*> m_frameWaiters;
+  bool m_deferLowPriority{false};
+  int m_deferPriority{0};
+  int m_deferPending{0};
+  std::chrono::steady_clock::time_point m_deferDeadline;
+
   bool m_destroyFrames{false};
 
   // Pool of frames/images to reduce malloc traffic.
@@ -0,0 +1,200 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "UsbBandwidth.h"
+
+#include <algorithm>
+#include <map>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+using namespace cs;
+
+// MJPEG is assumed to need 1/kMjpegRatio of the bandwidth of YUYV
+static constexpr uint64_t kMjpegRatio = 5;
+
+uint64_t cs::EstimateUsbBandwidth(const VideoMode& mode) {
+  if (mode.width <= 0 || mode.height <= 0 || mode.fps <= 0) return 0;
+  uint64_t pixels = static_cast<uint64_t>(mode.width) * mode.height * mode.fps;
+  switch (mode.pixelFormat) {
+    case VideoMode::kMJPEG:
+      return pixels * 2 / kMjpegRatio;
+    case VideoMode::kBGR:
+      return pixels * 3;
+    case VideoMode::kGray:
+      return pixels;
+    default:
+      return pixels * 2;
+  }
+}
+
+uint64_t cs::GetUsbBusCapacity(int speed) {
+  if (speed <= 0) return 0;
+  // Full speed: at most 90% of each frame can be periodic
+  if (speed <= 12) return 12000000 / 8 * 9 / 10;
+  // High speed: at most 80% of each microframe
+  if (speed <= 480) return 480000000 / 8 * 8 / 10;
+  // SuperSpeed and up: 8b/10b encoding, 90% periodic
+  return static_cast<uint64_t>(speed) * 1000000 / 10 * 9 / 10;
+}
+
+uint64_t cs::GetUsbDeviceCapacity(int speed) {
+  if (speed <= 0) return 0;
+  // Largest isochronous endpoint: 1023 bytes per frame (full speed),
+  // 3 x 1024 bytes per microframe (high speed), 3 x 16 x 1024 bytes per
+  // microframe (SuperSpeed)
+  if (speed <= 12) return 1023 * 1000;
+  if (speed <= 480) return 3 * 1024 * 8000;
+  return 3 * 16 * 1024 * 8000;
+}
+
+std::vector<VideoMode> cs::GetUsbModeCandidates(
+    const VideoMode& desired, llvm::ArrayRef<VideoMode> supported) {
+  std::vector<VideoMode> candidates;
+  candidates.push_back(desired);
+
+  std::vector<VideoMode> mjpeg;
+  for (const auto& mode : supported) {
+    if (mode.pixelFormat != VideoMode::kMJPEG || mode.width != desired.width ||
+        mode.height != desired.height || mode.fps > desired.fps)
+      continue;
+    if (mode.pixelFormat == desired.pixelFormat && mode.fps == desired.fps)
+      continue;
+    if (std::any_of(mjpeg.begin(), mjpeg.end(), [&](const VideoMode& oth) {
+          return oth.fps == mode.fps;
+        }))
+      continue;
+    mjpeg.push_back(mode);
+  }
+  std::sort(mjpeg.begin(), mjpeg.end(),
+            [](const VideoMode& a, const VideoMode& b) {
+              return a.fps > b.fps;
+            });
+  candidates.insert(candidates.end(), mjpeg.begin(), mjpeg.end());
+  return candidates;
+}
+
+static uint64_t ChoiceBandwidth(const UsbBandwidthCamera& camera,
+                                std::size_t choice) {
+  if (choice >= camera.candidates.size()) return 0;
+  return EstimateUsbBandwidth(camera.candidates[choice]);
+}
+
+bool cs::PlanUsbBandwidth(llvm::ArrayRef<UsbBandwidthCamera> cameras,
+                          std::vector<std::size_t>* choices) {
+  choices->assign(cameras.size(), 0);
+  bool fits = true;
+
+  // Each camera must fit its own link first
+  for (std::size_t i = 0; i < cameras.size(); ++i) {
+    const auto& camera = cameras[i];
+    if (camera.deviceCapacity == 0) continue;
+    auto& choice = (*choices)[i];
+    while (ChoiceBandwidth(camera, choice) > camera.deviceCapacity &&
+           choice + 1 < camera.candidates.size())
+      ++choice;
+    if (ChoiceBandwidth(camera, choice) > camera.deviceCapacity) fits = false;
+  }
+
+  // Group by bus; cameras with an unknown bus can't be planned
+  std::map<std::string, std::vector<std::size_t>> buses;
+  for (std::size_t i = 0; i < cameras.size(); ++i) {
+    if (!cameras[i].bus.empty()) buses[cameras[i].bus].push_back(i);
+  }
+
+  for (const auto& bus : buses) {
+    uint64_t capacity = 0;
+    for (auto i : bus.second) {
+      auto busCapacity = cameras[i].busCapacity;
+      if (busCapacity != 0 && (capacity == 0 || busCapacity < capacity))
+        capacity = busCapacity;
+    }
+    if (capacity == 0) continue;
+
+    // Step the camera using the most bandwidth to its next candidate until
+    // the bus fits
+    for (;;) {
+      uint64_t total = 0;
+      for (auto i : bus.second)
+        total += ChoiceBandwidth(cameras[i], (*choices)[i]);
+      if (total <= capacity) break;
+
+      std::size_t worst = cameras.size();
+      uint64_t worstBandwidth = 0;
+      for (auto i : bus.second) {
+        if ((*choices)[i] + 1 >= cameras[i].candidates.size()) continue;
+        auto bandwidth = ChoiceBandwidth(cameras[i], (*choices)[i]);
+        if (worst == cameras.size() || bandwidth > worstBandwidth) {
+          worst = i;
+          worstBandwidth = bandwidth;
+        }
+      }
+      if (worst == cameras.size()) {
+        fits = false;
+        break;
+      }
+      ++(*choices)[worst];
+    }
+  }
+  return fits;
+}
+
+#ifdef __linux__
+
+static bool ReadSysfsInt(const std::string& path, int* value) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  char buf[32];
+  ssize_t len = read(fd, buf, sizeof(buf));
+  close(fd);
+  if (len <= 0) return false;
+  // Speeds may be fractional ("1.5"); the integer part is enough
+  auto str = llvm::StringRef{buf, static_cast<std::size_t>(len)}.trim();
+  return !str.split('.').first.getAsInteger(10, *value);
+}
+
+bool cs::ReadUsbTopology(llvm::StringRef path, UsbBandwidthCamera* camera,
+                         llvm::StringRef sysfs) {
+  // Resolve links such as /dev/v4l/by-id/...
+  std::string devPath = path;
+  char buf[PATH_MAX];
+  if (realpath(devPath.c_str(), buf)) devPath = buf;
+  auto name = llvm::StringRef{devPath}.rsplit('/').second;
+  if (name.empty()) return false;
+
+  // The video device's parent is the USB interface (e.g. .../1-2/1-2:1.0),
+  // whose parent is the USB device
+  std::string interfacePath = sysfs;
+  interfacePath += "/class/video4linux/";
+  interfacePath += name.str();
+  interfacePath += "/device";
+  if (!realpath(interfacePath.c_str(), buf)) return false;
+  std::string devicePath = llvm::StringRef{buf}.rsplit('/').first;
+
+  int busnum, speed;
+  if (!ReadSysfsInt(devicePath + "/busnum", &busnum) ||
+      !ReadSysfsInt(devicePath + "/speed", &speed))
+    return false;
+
+  // The bus speed is that of its root hub
+  int busSpeed;
+  std::string rootPath = sysfs;
+  rootPath += "/bus/usb/devices/usb" + std::to_string(busnum) + "/speed";
+  if (!ReadSysfsInt(rootPath, &busSpeed)) busSpeed = speed;
+
+  camera->bus = std::to_string(busnum);
+  camera->busCapacity = GetUsbBusCapacity(busSpeed);
+  camera->deviceCapacity = GetUsbDeviceCapacity(speed);
+  return true;
+}
+
+#endif  // __linux__
@@ -0,0 +1,68 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef CS_USBBANDWIDTH_H_
+#define CS_USBBANDWIDTH_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "llvm/ArrayRef.h"
+#include "llvm/StringRef.h"
+
+#include "cscore_cpp.h"
+
+namespace cs {
+
+// USB video mode planning.  UVC cameras reserve isochronous (periodic)
+// bandwidth when streaming starts, and cameras sharing a bus can
+// oversubscribe it, failing VIDIOC_STREAMON or dropping frames.  These
+// functions work on a plain description of the topology so plans can be
+// made (and tested) without hardware.  All bandwidths are in bytes/s.
+
+struct UsbBandwidthCamera {
+  // Cameras with the same (nonempty) bus share its capacity
+  std::string bus;
+  uint64_t busCapacity = 0;     // 0 if unknown (unlimited)
+  uint64_t deviceCapacity = 0;  // limit of the device's own link, 0 if unknown
+  // Modes to choose from, most preferred first
+  std::vector<VideoMode> candidates;
+};
+
+// Estimated bandwidth of a mode.  Compressed formats are assumed to
+// compress well; the reservation a camera actually makes may be larger.
+uint64_t EstimateUsbBandwidth(const VideoMode& mode);
+
+// Periodic bandwidth available on a bus, and to a single device, for a
+// link speed in Mbit/s (as reported by sysfs).  0 if the speed is unknown.
+uint64_t GetUsbBusCapacity(int speed);
+uint64_t GetUsbDeviceCapacity(int speed);
+
+// Candidate modes for a camera, most preferred first: the desired mode,
+// then MJPEG at the same resolution from the desired frame rate down.
+// Resolution is never changed.
+std::vector<VideoMode> GetUsbModeCandidates(
+    const VideoMode& desired, llvm::ArrayRef<VideoMode> supported);
+
+// Chooses a candidate (index) for each camera, giving up preference on the
+// cameras using the most bandwidth until every bus fits.  Returns false if
+// a bus or device is oversubscribed even with the last candidates.
+bool PlanUsbBandwidth(llvm::ArrayRef<UsbBandwidthCamera> cameras,
+                      std::vector<std::size_t>* choices);
+
+#ifdef __linux__
+// Fills in the bus and capacities of the video device at path from sysfs.
+// Returns false if it is not a USB device.
+bool ReadUsbTopology(llvm::StringRef path, UsbBandwidthCamera* camera,
+                     llvm::StringRef sysfs = "/sys");
+#endif
+
+}  // namespace cs
+
+#endif  // CS_USBBANDWIDTH_H_
@@ -0,0 +1,252 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifdef __linux__
+
+#include "UsbCameraCache.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "llvm/SmallString.h"
+#include "llvm/raw_ostream.h"
+#include "support/raw_istream.h"
+
+#include "HttpUtil.h"
+#include "Log.h"
+#include "UsbCameraProperty.h"
+
+using namespace cs;
+
+ATOMIC_STATIC_INIT(UsbCameraCache)
+
+// File format (one record per line, names and keys last as they may contain
+// spaces):
+//   camera <key>
+//   mode <pixelFormat> <width> <height> <fps>
+//   control <id> <type> <kind> <min> <max> <step> <default> <name>
+//   choice <index> <text>       (belongs to the preceding control)
+static constexpr const char* kFileHeader = "# cscore USB camera cache v1";
+
+UsbCameraCache::Control::Control(const UsbCameraProperty& prop)
+    : name(prop.name),
+      id(prop.id),
+      type(prop.type),
+      kind(prop.propKind),
+      minimum(prop.minimum),
+      maximum(prop.maximum),
+      step(prop.step),
+      defaultValue(prop.defaultValue),
+      enumChoices(prop.enumChoices) {}
+
+std::unique_ptr<UsbCameraProperty> UsbCameraCache::Control::ToProperty()
+    const {
+  auto prop = llvm::make_unique<UsbCameraProperty>(name);
+  prop->id = id;
+  prop->type = type;
+  prop->propKind = static_cast<CS_PropertyKind>(kind);
+  prop->hasMinimum = true;
+  prop->minimum = minimum;
+  prop->hasMaximum = true;
+  prop->maximum = maximum;
+  prop->step = step;
+  prop->defaultValue = defaultValue;
+  prop->enumChoices = enumChoices;
+  return prop;
+}
+
+bool UsbCameraCache::Control::operator==(const Control& oth) const {
+  return name == oth.name && id == oth.id && type == oth.type &&
+         kind == oth.kind && minimum == oth.minimum &&
+         maximum == oth.maximum && step == oth.step &&
+         defaultValue == oth.defaultValue && enumChoices == oth.enumChoices;
+}
+
+bool UsbCameraCache::Entry::operator==(const Entry& oth) const {
+  if (controls != oth.controls || modes.size() != oth.modes.size())
+    return false;
+  for (std::size_t i = 0; i < modes.size(); ++i) {
+    if (modes[i].pixelFormat != oth.modes[i].pixelFormat ||
+        modes[i].width != oth.modes[i].width ||
+        modes[i].height != oth.modes[i].height ||
+        modes[i].fps != oth.modes[i].fps)
+      return false;
+  }
+  return true;
+}
+
+void UsbCameraCache::SetPath(llvm::StringRef path) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (path == m_path) return;
+  m_path = path;
+  m_loaded = false;
+  m_entries.clear();
+}
+
+std::string UsbCameraCache::GetPath() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_path;
+}
+
+bool UsbCameraCache::IsEnabled() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return !m_path.empty();
+}
+
+bool UsbCameraCache::Get(llvm::StringRef key, Entry* entry) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_path.empty()) return false;
+  if (!m_loaded) Load();
+  auto it = m_entries.find(key);
+  if (it == m_entries.end()) return false;
+  *entry = it->getValue();
+  return true;
+}
+
+void UsbCameraCache::Put(llvm::StringRef key, const Entry& entry) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_path.empty()) return;
+  if (!m_loaded) Load();
+  m_entries[key] = entry;
+  Save();
+}
+
+// Splits the next space-separated integer off str
+static bool ParseInt(llvm::StringRef* str, int* value) {
+  auto parts = str->ltrim().split(' ');
+  *str = parts.second;
+  return !parts.first.getAsInteger(10, *value);
+}
+
+void UsbCameraCache::Load() {
+  m_loaded = true;
+  m_entries.clear();
+
+  int fd = open(m_path.c_str(), O_RDONLY);
+  if (fd < 0) return;
+  wpi::raw_fd_istream is{fd, true};
+
+  Entry* entry = nullptr;
+  Control* control = nullptr;
+  llvm::SmallString<128> lineBuf;
+  for (;;) {
+    bool error = false;
+    auto line = ReadLine(is, lineBuf, 4096, &error).rtrim("\n");
+    if (line.empty()) {
+      if (error) break;
+      continue;
+    }
+
+    llvm::StringRef rest;
+    std::tie(line, rest) = line.split(' ');
+    bool ok = true;
+    if (line == "camera") {
+      entry = &m_entries[rest];
+      *entry = Entry{};
+      control = nullptr;
+    } else if (line == "mode" && entry) {
+      int pixelFormat, width, height, fps;
+      ok = ParseInt(&rest, &pixelFormat) && ParseInt(&rest, &width) &&
+           ParseInt(&rest, &height) && ParseInt(&rest, &fps);
+      if (ok) {
+        entry->modes.emplace_back(
+            static_cast<VideoMode::PixelFormat>(pixelFormat), width, height,
+            fps);
+      }
+    } else if (line == "control" && entry) {
+      Control c;
+      int id;
+      ok = ParseInt(&rest, &id) && ParseInt(&rest, &c.type) &&
+           ParseInt(&rest, &c.kind) && ParseInt(&rest, &c.minimum) &&
+           ParseInt(&rest, &c.maximum) && ParseInt(&rest, &c.step) &&
+           ParseInt(&rest, &c.defaultValue);
+      if (ok) {
+        c.id = static_cast<unsigned>(id);
+        c.name = rest;
+        // Match UsbCameraProperty::DeviceQuery()
+        if (c.kind == CS_PROP_ENUM && c.maximum >= 0 && c.maximum < 4096)
+          c.enumChoices.resize(c.maximum + 1);
+        entry->controls.emplace_back(std::move(c));
+        control = &entry->controls.back();
+      }
+    } else if (line == "choice" && control) {
+      int index;
+      ok = ParseInt(&rest, &index) && index >= 0 && index < 4096;
+      if (ok) {
+        if (control->enumChoices.size() <= static_cast<std::size_t>(index))
+          control->enumChoices.resize(index + 1);
+        control->enumChoices[index] = rest;
+      }
+    }
+    if (!ok) {
+      WARNING("USB camera cache " << m_path << " is corrupt; ignoring it");
+      m_entries.clear();
+      return;
+    }
+    if (error) break;
+  }
+  DEBUG("loaded " << m_entries.size() << " cameras from USB camera cache "
+                  << m_path);
+}
+
+void UsbCameraCache::Save() {
+  // Write to a temporary file and rename it into place so a crash can't
+  // leave a partial cache behind
+  std::string tmpPath = m_path + ".tmp";
+  int fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    WARNING("could not write USB camera cache " << tmpPath << ": "
+                                                << std::strerror(errno));
+    return;
+  }
+  bool ok;
+  {
+    llvm::raw_fd_ostream os{fd, false};
+    os << kFileHeader << '\n';
+    for (const auto& item : m_entries) {
+      const Entry& entry = item.getValue();
+      os << "camera " << item.getKey() << '\n';
+      for (const auto& mode : entry.modes) {
+        os << "mode " << mode.pixelFormat << ' ' << mode.width << ' '
+           << mode.height << ' ' << mode.fps << '\n';
+      }
+      for (const auto& c : entry.controls) {
+        os << "control " << static_cast<int>(c.id) << ' ' << c.type << ' '
+           << c.kind << ' ' << c.minimum << ' ' << c.maximum << ' ' << c.step
+           << ' ' << c.defaultValue << ' ' << c.name << '\n';
+        for (std::size_t i = 0; i < c.enumChoices.size(); ++i) {
+          if (c.enumChoices[i].empty()) continue;
+          os << "choice " << i << ' ' << c.enumChoices[i] << '\n';
+        }
+      }
+    }
+    os.flush();
+    ok = !os.has_error();
+    // Clear the error so the stream doesn't report it as fatal on destruction
+    os.clear_error();
+  }
+  // Make sure the data is on disk before the rename makes it visible
+  if (ok && fsync(fd) != 0) ok = false;
+  if (close(fd) != 0) ok = false;
+  if (!ok) {
+    WARNING("could not write USB camera cache " << tmpPath);
+    unlink(tmpPath.c_str());
+    return;
+  }
+  if (std::rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+    WARNING("could not write USB camera cache " << m_path << ": "
+                                                << std::strerror(errno));
+    unlink(tmpPath.c_str());
+  }
+}
+
+#endif  // __linux__
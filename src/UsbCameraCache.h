@@ -0,0 +1,90 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef CS_USBCAMERACACHE_H_
+#define CS_USBCAMERACACHE_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "llvm/StringMap.h"
+#include "llvm/StringRef.h"
+#include "support/atomic_static.h"
+
+#include "cscore_cpp.h"
+
+namespace cs {
+
+class UsbCameraProperty;
+
+// Optional on-disk cache of USB camera capabilities (video modes and control
+// metadata), keyed by device identity and driver version, so a camera seen
+// before can skip enumeration when it connects.  Disabled (empty path) by
+// default.
+class UsbCameraCache {
+ public:
+  // Control metadata as returned by the driver (values are not cached)
+  struct Control {
+    Control() = default;
+    explicit Control(const UsbCameraProperty& prop);
+    std::unique_ptr<UsbCameraProperty> ToProperty() const;
+    bool operator==(const Control& oth) const;
+
+    std::string name;
+    unsigned id{0};
+    int type{0};
+    int kind{0};
+    int minimum{0};
+    int maximum{0};
+    int step{0};
+    int defaultValue{0};
+    std::vector<std::string> enumChoices;
+  };
+
+  struct Entry {
+    bool operator==(const Entry& oth) const;
+    bool operator!=(const Entry& oth) const { return !(*this == oth); }
+
+    std::vector<Control> controls;
+    std::vector<VideoMode> modes;
+  };
+
+  static UsbCameraCache& GetInstance() {
+    ATOMIC_STATIC(UsbCameraCache, instance);
+    return instance;
+  }
+
+  // Sets the cache file.  An empty path disables the cache.
+  void SetPath(llvm::StringRef path);
+  std::string GetPath() const;
+  bool IsEnabled() const;
+
+  // Looks up the entry for key.  Returns false if not cached.
+  bool Get(llvm::StringRef key, Entry* entry);
+
+  // Stores (or replaces) the entry for key and rewrites the file.
+  void Put(llvm::StringRef key, const Entry& entry);
+
+ private:
+  UsbCameraCache() = default;
+
+  void Load();
+  void Save();
+
+  mutable std::mutex m_mutex;
+  std::string m_path;
+  bool m_loaded{false};
+  llvm::StringMap<Entry> m_entries;
+
+  ATOMIC_STATIC_DECL(UsbCameraCache)
+};
+
+}  // namespace cs
+
+#endif  // CS_USBCAMERACACHE_H_
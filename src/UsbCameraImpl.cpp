@@ -16,13 +16,14 @@
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <linux/videodev2.h>
+#include <poll.h>
 #include <sys/eventfd.h>
 #include <sys/inotify.h>
 #include <sys/ioctl.h>
-#include <sys/select.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #elif defined(_WIN32)
@@ -38,6 +39,9 @@
 #include "Handle.h"
 #include "Log.h"
 #include "Notifier.h"
+#include "UsbBandwidth.h"
+#include "UsbCameraReactor.h"
+#include "UsbCameraRegistry.h"
 #include "UsbUtil.h"
 
 using namespace cs;
@@ -47,9 +51,29 @@ static constexpr char const* kPropWbValue = "white_balance_temperature";
 static constexpr char const* kPropExAuto = "exposure_auto";
 static constexpr char const* kPropExValue = "exposure_absolute";
 static constexpr char const* kPropBrValue = "brightness";
+static constexpr char const* kPropBufferCount = "buffer_count";
+
+// Adaptive buffer count window length, in Frame::Time units (100 ns)
+static constexpr uint64_t kBufferAdaptWindow = 50000000;  // 5 s
+// Number of consecutive windows without drops before shrinking
+static constexpr int kBufferAdaptCalmWindows = 6;
+// Minimum time between frames dropped notifications (1 s)
+static constexpr uint64_t kFramesDroppedNotifyInterval = 10000000;
 
 #ifdef __linux__
 
+// Capture statistics have a single writer (the camera thread), so plain
+// loads and stores suffice
+static void StatAdd(std::atomic<uint64_t>& stat, uint64_t value) {
+  stat.store(stat.load(std::memory_order_relaxed) + value,
+             std::memory_order_relaxed);
+}
+
+static void StatMax(std::atomic<uint64_t>& stat, uint64_t value) {
+  if (value > stat.load(std::memory_order_relaxed))
+    stat.store(value, std::memory_order_relaxed);
+}
+
 // Conversions v4l2_fract time per frame from/to frames per second (fps)
 static inline int FractToFPS(const struct v4l2_fract& timeperframe) {
   return (1.0 * timeperframe.denominator) / timeperframe.numerator;
@@ -98,6 +122,35 @@ static __u32 FromPixelFormat(VideoMode::PixelFormat pixelFormat) {
   }
 }
 
+// Age (in 100 ns units) of a v4l2_buffer's capture timestamp.  Only
+// monotonic timestamps (the default for UVC) can be compared with the
+// current time; returns false otherwise or if the timestamp is in the future.
+static bool GetCaptureAge(const struct v4l2_buffer& buf, uint64_t* age) {
+  if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) !=
+      V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+    return false;
+
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) return false;
+  int64_t monoNow = static_cast<int64_t>(ts.tv_sec) * 10000000 +
+                    ts.tv_nsec / 100;
+  int64_t captured = static_cast<int64_t>(buf.timestamp.tv_sec) * 10000000 +
+                     buf.timestamp.tv_usec * 10;
+  if (captured > monoNow) return false;
+  *age = monoNow - captured;
+  return true;
+}
+
+// Conversion of a v4l2_buffer timestamp to the frame time base (100 ns units
+// of wpi::Now()).  If the timestamp can't be converted (or is more than a
+// second old, so looks bogus) returns now.
+static Frame::Time ToFrameTime(const struct v4l2_buffer& buf,
+                               Frame::Time now) {
+  uint64_t age;
+  if (!GetCaptureAge(buf, &age) || age > 10000000) return now;
+  return now - age;
+}
+
 static bool IsPercentageProperty(llvm::StringRef name) {
   if (name.startswith("raw_")) name = name.substr(4);
   return name == "brightness" || name == "contrast" || name == "saturation" ||
@@ -156,6 +209,22 @@ static bool GetDescriptionSysV4L(llvm::StringRef path, std::string* desc) {
   return true;
 }
 
+static std::string GetDescriptionCard(const struct v4l2_capability& vcap) {
+  llvm::StringRef card{reinterpret_cast<const char*>(vcap.card)};
+  // try to convert "UVC Camera (0000:0000)" into a better name
+  int vendor = 0;
+  int product = 0;
+  if (card.startswith("UVC Camera (") &&
+      !card.substr(12, 4).getAsInteger(16, vendor) &&
+      !card.substr(17, 4).getAsInteger(16, product)) {
+    llvm::SmallString<64> card2Buf;
+    llvm::StringRef card2 = GetUsbNameFromId(vendor, product, card2Buf);
+    if (!card2.empty()) return card2;
+  }
+
+  return card;
+}
+
 static bool GetDescriptionIoctl(const char* cpath, std::string* desc) {
   int fd = open(cpath, O_RDWR);
   if (fd < 0) return false;
@@ -168,26 +237,48 @@ static bool GetDescriptionIoctl(const char* cpath, std::string* desc) {
   }
   close(fd);
 
-  llvm::StringRef card{reinterpret_cast<const char*>(vcap.card)};
-  // try to convert "UVC Camera (0000:0000)" into a better name
-  int vendor = 0;
-  int product = 0;
-  if (card.startswith("UVC Camera (") &&
-      !card.substr(12, 4).getAsInteger(16, vendor) &&
-      !card.substr(17, 4).getAsInteger(16, product)) {
-    llvm::SmallString<64> card2Buf;
-    llvm::StringRef card2 = GetUsbNameFromId(vendor, product, card2Buf);
-    if (!card2.empty()) {
-      *desc = card2;
-      return true;
+  *desc = GetDescriptionCard(vcap);
+  return true;
+}
+
+// Capability cache key: the /dev/v4l/by-id name (which includes the serial
+// number if the device has one) or the card name and bus location, plus the
+// driver name and version.  Empty if no key can be formed.
+static std::string GetCapabilityCacheKey(const char* cpath,
+                                         const struct v4l2_capability& vcap) {
+  if (vcap.driver[0] == '\0') return std::string{};
+
+  llvm::SmallString<128> key;
+  llvm::raw_svector_ostream oss{key};
+  char devPath[PATH_MAX];
+  if (realpath(cpath, devPath)) {
+    if (DIR* dp = opendir("/dev/v4l/by-id")) {
+      while (struct dirent* ep = readdir(dp)) {
+        if (ep->d_name[0] == '.') continue;
+        llvm::SmallString<128> linkPath{"/dev/v4l/by-id/"};
+        linkPath += ep->d_name;
+        linkPath.push_back('\0');
+        char target[PATH_MAX];
+        if (realpath(linkPath.data(), target) &&
+            std::strcmp(target, devPath) == 0) {
+          oss << ep->d_name;
+          break;
+        }
+      }
+      closedir(dp);
     }
   }
-
-  *desc = card;
-  return true;
+  if (key.empty()) {
+    oss << reinterpret_cast<const char*>(vcap.card) << '@'
+        << reinterpret_cast<const char*>(vcap.bus_info);
+  }
+  oss << ' ' << reinterpret_cast<const char*>(vcap.driver) << ' '
+      << vcap.version;
+  return oss.str();
 }
 
-static std::string GetDescriptionImpl(const char* cpath) {
+// Gets the description from the /sys tree without opening the device
+static bool GetDescriptionSysfs(const char* cpath, std::string* desc) {
   llvm::StringRef path{cpath};
   char pathBuf[128];
   std::string rv;
@@ -201,10 +292,13 @@ static std::string GetDescriptionImpl(const char* cpath) {
     if (n > 0) path = llvm::StringRef(pathBuf, n);
   }
 
-  if (path.startswith("/dev/video")) {
-    // Sometimes the /sys tree gives a better name.
-    if (GetDescriptionSysV4L(path, &rv)) return rv;
-  }
+  // Sometimes the /sys tree gives a better name.
+  return path.startswith("/dev/video") && GetDescriptionSysV4L(path, desc);
+}
+
+static std::string GetDescriptionImpl(const char* cpath) {
+  std::string rv;
+  if (GetDescriptionSysfs(cpath, &rv)) return rv;
 
   // Otherwise use an ioctl to query the caps and get the card name
   if (GetDescriptionIoctl(cpath, &rv)) return rv;
@@ -212,14 +306,36 @@ static std::string GetDescriptionImpl(const char* cpath) {
   return std::string{};
 }
 
+std::string cs::GetUsbCameraDescription(const char* path) {
+  return GetDescriptionImpl(path);
+}
+
 UsbCameraImpl::UsbCameraImpl(llvm::StringRef name, llvm::StringRef path)
     : SourceImpl{name},
       m_path{path},
       m_fd{-1},
       m_command_fd{eventfd(0, 0)},
       m_active{true} {
-  SetDescription(GetDescriptionImpl(m_path.c_str()));
-  SetQuirks();
+  m_bufferState = std::make_shared<BufferState>();
+  m_bufferState->wakeFd = m_command_fd;
+
+  // Split the path for hotplug (inotify) matching
+  llvm::SmallString<64> pathCopy{m_path};
+  pathCopy.push_back('\0');
+  m_pathDir = dirname(pathCopy.data());
+  pathCopy = m_path;
+  pathCopy.push_back('\0');
+  m_pathBase = basename(pathCopy.data());
+
+  // Set the description and quirks now if the /sys tree has them; getting
+  // them otherwise needs the device opened, which the camera thread does on
+  // connect, so creation doesn't block on the device.
+  std::string desc;
+  if (GetDescriptionSysfs(m_path.c_str(), &desc)) {
+    SetDescription(desc);
+    SetQuirks();
+  }
+  m_startTime = wpi::Now();
 }
 
 UsbCameraImpl::~UsbCameraImpl() {
@@ -228,27 +344,41 @@ UsbCameraImpl::~UsbCameraImpl() {
   // Just in case anyone is waiting...
   m_responseCv.notify_all();
 
-  // Send message to wake up thread; select timeout will wake us up anyway,
-  // but this speeds shutdown.
-  Send(Message{Message::kNone});
+  if (m_reactor) {
+    // Wait for the reactor to shut down the device and forget us (if it's
+    // already destroyed, it has done so)
+    if (!UsbCameraReactor::destroyed())
+      UsbCameraReactor::GetInstance().Remove(this);
+  } else {
+    // Send message to wake up thread; poll timeout will wake us up anyway,
+    // but this speeds shutdown.
+    Send(Message{Message::kNone});
+
+    // join camera thread
+    if (m_cameraThread.joinable()) m_cameraThread.join();
+  }
 
-  // join camera thread
-  if (m_cameraThread.joinable()) m_cameraThread.join();
+  // The capability check may still be enumerating
+  if (m_validateThread.joinable()) m_validateThread.join();
+
+  // Outstanding zero-copy frames must no longer wake the (dead) thread
+  {
+    std::lock_guard<std::mutex> lock(m_bufferState->mutex);
+    m_bufferState->wakeFd = -1;
+  }
 
   // close command fd
   int fd = m_command_fd.exchange(-1);
   if (fd >= 0) close(fd);
 }
 
-static inline void DoFdSet(int fd, fd_set* set, int* nfds) {
-  if (fd >= 0) {
-    FD_SET(fd, set);
-    if ((fd + 1) > *nfds) *nfds = fd + 1;
-  }
-}
-
 void UsbCameraImpl::Start() {
-  // Kick off the camera thread
+  // Use the shared capture reactor if enabled, otherwise kick off the camera
+  // thread
+  if (UsbCameraReactor::GetInstance().Add(this)) {
+    m_reactor = true;
+    return;
+  }
   m_cameraThread = std::thread(&UsbCameraImpl::CameraThreadMain, this);
 }
 
@@ -270,64 +400,29 @@ void UsbCameraImpl::CameraThreadMain() {
           notify_fd, true, sizeof(struct inotify_event) + NAME_MAX + 1});
     }
   }
-  bool notified = (notify_fd < 0);  // treat as always notified if cannot notify
-
-  // Get the basename for later notify use
-  llvm::SmallString<64> pathCopy{m_path};
-  pathCopy.push_back('\0');
-  llvm::SmallString<64> base{basename(pathCopy.data())};
-
-  // Used to restart streaming on reconnect
-  bool wasStreaming = false;
-
-  // Default to not streaming
-  m_streaming = false;
+  DeviceInit(notify_fd >= 0);
 
   while (m_active) {
-    // If not connected, try to reconnect
-    if (m_fd < 0) DeviceConnect();
+    int timeout = DeviceUpdate();
 
     // Make copies of fd's in case they go away
     int command_fd = m_command_fd.load();
     int fd = m_fd.load();
     if (!m_active) break;
 
-    // Reset notified flag and restart streaming if necessary
-    if (fd >= 0) {
-      notified = (notify_fd < 0);
-      if (wasStreaming && !m_streaming) {
-        DeviceStreamOn();
-        wasStreaming = false;
-      }
-    }
-
-    // Turn off streaming if no one is listening, and turn it on if there is.
-    if (m_streaming && m_numSinksEnabled == 0) {
-      DeviceStreamOff();
-    } else if (!m_streaming && m_numSinksEnabled > 0) {
-      DeviceStreamOn();
+    // poll on applicable read descriptors
+    struct pollfd pfds[3];
+    pfds[0].fd = command_fd;
+    pfds[1].fd = m_streaming ? fd : -1;
+    pfds[2].fd = notify_fd;
+    for (auto& pfd : pfds) {
+      pfd.events = POLLIN;
+      pfd.revents = 0;
     }
 
-    // The select timeout can be long unless we're trying to reconnect
-    struct timeval tv;
-    if (fd < 0 && notified) {
-      tv.tv_sec = 0;
-      tv.tv_usec = 300000;
-    } else {
-      tv.tv_sec = 2;
-      tv.tv_usec = 0;
-    }
-
-    // select on applicable read descriptors
-    int nfds = 0;
-    fd_set readfds;
-    FD_ZERO(&readfds);
-    DoFdSet(command_fd, &readfds, &nfds);
-    if (m_streaming) DoFdSet(fd, &readfds, &nfds);
-    DoFdSet(notify_fd, &readfds, &nfds);
-
-    if (select(nfds, &readfds, nullptr, nullptr, &tv) < 0) {
-      SERROR("select(): " << strerror(errno));
+    if (poll(pfds, 3, timeout) < 0) {
+      if (errno == EINTR) continue;
+      SERROR("poll(): " << strerror(errno));
       break;  // XXX: is this the right thing to do here?
     }
 
@@ -335,7 +430,7 @@ void UsbCameraImpl::CameraThreadMain() {
     if (!m_active) break;
 
     // Handle notify events
-    if (notify_fd >= 0 && FD_ISSET(notify_fd, &readfds)) {
+    if ((pfds[2].revents & POLLIN) != 0) {
       SDEBUG4("notify event");
       struct inotify_event event;
       do {
@@ -348,78 +443,294 @@ void UsbCameraImpl::CameraThreadMain() {
         // If the name is what we expect...
         llvm::StringRef name{raw_name.c_str()};
         SDEBUG4("got event on '" << name << "' (" << name.size()
-                                 << ") compare to '" << base << "' ("
-                                 << base.size() << ") mask " << event.mask);
-        if (name == base) {
-          if ((event.mask & IN_DELETE) != 0) {
-            wasStreaming = m_streaming;
-            DeviceStreamOff();
-            DeviceDisconnect();
-          } else if ((event.mask & IN_CREATE) != 0) {
-            notified = true;
-          }
-        }
+                                 << ") compare to '" << m_pathBase << "' ("
+                                 << m_pathBase.size() << ") mask "
+                                 << event.mask);
+        if (name == m_pathBase) DeviceHotplug(event.mask);
       } while (!notify_is->has_error() &&
                notify_is->in_avail() >= sizeof(event));
       continue;
     }
 
     // Handle commands
-    if (command_fd >= 0 && FD_ISSET(command_fd, &readfds)) {
-      SDEBUG4("got command");
-      // Read it to clear
-      eventfd_t val;
-      eventfd_read(command_fd, &val);
-      DeviceProcessCommands();
+    if ((pfds[0].revents & POLLIN) != 0) {
+      DeviceHandleCommand();
       continue;
     }
 
     // Handle frames
-    if (m_streaming && fd >= 0 && FD_ISSET(fd, &readfds)) {
-      SDEBUG4("grabbing image");
+    if (m_streaming && fd >= 0 && (pfds[1].revents & POLLIN) != 0)
+      DeviceHandleFrame();
+  }
 
-      // Dequeue buffer
-      struct v4l2_buffer buf;
-      std::memset(&buf, 0, sizeof(buf));
-      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-      buf.memory = V4L2_MEMORY_MMAP;
-      if (DoIoctl(fd, VIDIOC_DQBUF, &buf) != 0) {
-        SWARNING("could not dequeue buffer");
-        wasStreaming = m_streaming;
-        DeviceStreamOff();
-        DeviceDisconnect();
-        notified = true;  // device wasn't deleted, just error'ed
-        continue;  // will reconnect
-      }
+  DeviceShutdown();
+}
 
-      if ((buf.flags & V4L2_BUF_FLAG_ERROR) == 0) {
-        SDEBUG4("got image size=" << buf.bytesused << " index=" << buf.index);
+void UsbCameraImpl::DeviceInit(bool hotplugWatched) {
+  // Treat as always notified if cannot notify
+  m_hotplugWatched = hotplugWatched;
+  m_notified = !hotplugWatched;
 
-        if (buf.index >= kNumBuffers || !m_buffers[buf.index].m_data) {
-          SWARNING("invalid buffer" << buf.index);
-          continue;
-        }
+  // Used to restart streaming on reconnect
+  m_wasStreaming = false;
 
-        PutFrame(static_cast<VideoMode::PixelFormat>(m_mode.pixelFormat),
-                 m_mode.width, m_mode.height,
-                 llvm::StringRef(
-                     static_cast<const char*>(m_buffers[buf.index].m_data),
-                     static_cast<std::size_t>(buf.bytesused)),
-                 wpi::Now());  // TODO: time
-      }
+  // Default to not streaming
+  m_streaming = false;
+}
+
+int UsbCameraImpl::DeviceUpdate() {
+  // If not connected, try to reconnect
+  if (m_fd < 0) DeviceConnect();
+
+  int fd = m_fd.load();
+  if (!m_active) return 0;
+
+  // Reset notified flag and restart streaming if necessary
+  if (fd >= 0) {
+    m_notified = !m_hotplugWatched;
+    if (m_wasStreaming && !m_streaming) {
+      DeviceStreamOn();
+      m_wasStreaming = false;
+    }
+  }
 
-      // Requeue buffer
-      if (DoIoctl(fd, VIDIOC_QBUF, &buf) != 0) {
-        SWARNING("could not requeue buffer");
-        wasStreaming = m_streaming;
+  // Turn on streaming if anyone is listening.  When no one is, keep
+  // streaming for the linger period, then either turn it off or drop to the
+  // standby rate.
+  int lingerTimeout = -1;
+  if (!m_streaming) m_standby = false;
+  if (m_numSinksEnabled > 0) {
+    m_idleSince = 0;
+    m_standby = false;
+    if (!m_streaming) DeviceStreamOn();
+  } else if (m_streaming && !m_standby) {
+    auto now = wpi::Now();
+    if (m_idleSince == 0) m_idleSince = now;
+    auto linger = static_cast<uint64_t>(m_linger * 10000000.0);
+    if (now - m_idleSince >= linger) {
+      m_idleSince = 0;
+      if (m_standbyFPS > 0) {
+        SDEBUG("entering standby");
+        m_standby = true;
+      } else {
         DeviceStreamOff();
-        DeviceDisconnect();
-        notified = true;  // device wasn't deleted, just error'ed
-        continue;  // will reconnect
       }
+    } else {
+      lingerTimeout = (linger - (now - m_idleSince)) / 10000 + 1;
+    }
+  } else if (m_streaming && m_standbyFPS <= 0) {
+    m_standby = false;
+    DeviceStreamOff();
+  }
+
+  // Give buffers released by zero-copy frames back to the driver
+  DeviceRequeueBuffers();
+
+  // Reallocate buffers if the adaptive buffer count changed (or adaptation
+  // was turned off while above the requested count)
+  if (!m_adaptiveBuffers && m_bufferCountTarget != m_bufferCountSetting) {
+    m_bufferCountTarget = m_bufferCountSetting;
+    m_bufferCountChanged = true;
+  }
+  if (m_bufferCountChanged) {
+    m_bufferCountChanged = false;
+    SDEBUG("changing buffer count to " << m_bufferCountTarget);
+    DeviceReallocBuffers(false);
+    return 0;  // fd may have changed
+  }
+
+  // Switch modes if auto video mode wants to
+  VideoMode autoMode;
+  if (fd >= 0 && CheckAutoVideoMode(&autoMode)) {
+    SDEBUG("auto video mode: " << autoMode.width << "x" << autoMode.height
+                               << " type " << autoMode.pixelFormat);
+    Message msg{Message::kCmdSetMode};
+    msg.data[0] = autoMode.pixelFormat;
+    msg.data[1] = autoMode.width;
+    msg.data[2] = autoMode.height;
+    msg.data[3] = autoMode.fps;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    DeviceCmdSetMode(lock, msg);
+    return 0;  // fd may have changed
+  }
+
+  // Check cached capabilities against the device once startup is done; the
+  // enumeration runs on its own thread so it doesn't stall capture
+  if (m_validateCapabilities && m_fd >= 0 && (m_startTime == 0 || !m_streaming))
+    DeviceValidateCapabilities();
+  if (m_capabilitiesChecked) DeviceApplyCheckedCapabilities();
+
+  // The timeout can be long unless we're trying to reconnect or lingering
+  int timeout = (fd < 0 && m_notified) ? 300 : 2000;
+  if (lingerTimeout >= 0 && lingerTimeout < timeout) timeout = lingerTimeout;
+  return timeout;
+}
+
+bool UsbCameraImpl::DeviceCheckStandby() {
+  if (!m_standby) return true;
+  double fps = m_standbyFPS;
+  if (fps <= 0) return true;
+  auto now = wpi::Now();
+  auto interval = static_cast<uint64_t>(10000000.0 / fps);
+  if (m_lastStandbyFrame != 0 && now - m_lastStandbyFrame < interval)
+    return false;
+  m_lastStandbyFrame = now;
+  return true;
+}
+
+void UsbCameraImpl::DeviceHotplug(uint32_t mask) {
+  if ((mask & IN_DELETE) != 0) {
+    if (m_fd >= 0) m_lost = true;
+    m_wasStreaming = m_streaming;
+    DeviceStreamOff();
+    DeviceDisconnect();
+  }
+  if ((mask & IN_CREATE) != 0) m_notified = true;
+}
+
+void UsbCameraImpl::PostHotplug(uint32_t mask) {
+  m_hotplugEvents |= mask;
+  int fd = m_command_fd.load();
+  if (fd >= 0) eventfd_write(fd, 1);
+}
+
+void UsbCameraImpl::DeviceHandleCommand() {
+  SDEBUG4("got command");
+  // Read it to clear
+  eventfd_t val;
+  eventfd_read(m_command_fd.load(), &val);
+
+  // Hotplug events forwarded by the reactor
+  uint32_t hotplug = m_hotplugEvents.exchange(0);
+  if (hotplug != 0) DeviceHotplug(hotplug);
+
+  DeviceProcessCommands();
+}
+
+void UsbCameraImpl::DeviceHandleFrame() {
+  int fd = m_fd.load();
+  if (fd < 0) return;
+
+  SDEBUG4("grabbing image");
+
+  // Dequeue buffer
+  struct v4l2_buffer buf;
+  std::memset(&buf, 0, sizeof(buf));
+  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.memory = m_memory;
+  if (DoIoctl(fd, VIDIOC_DQBUF, &buf) != 0) {
+    SWARNING("could not dequeue buffer");
+    m_lost = true;
+    m_wasStreaming = m_streaming;
+    DeviceStreamOff();
+    DeviceDisconnect();
+    m_notified = true;  // device wasn't deleted, just error'ed
+    return;  // will reconnect
+  }
+  DeviceRecordBuffer(buf, wpi::Now());
+
+  if (m_startTime != 0) {
+    SINFO("first frame " << (wpi::Now() - m_startTime) / 10000
+                         << " ms after creation");
+    m_startTime = 0;
+  }
+  if (m_modeSwitchStart != 0) {
+    SINFO("first frame " << (wpi::Now() - m_modeSwitchStart) / 10000
+                         << " ms after mode switch");
+    m_modeSwitchStart = 0;
+  }
+
+  if (m_adaptiveBuffers) DeviceTrackBuffers(buf);
+
+  // In low latency mode, skip ahead to the newest ready buffer,
+  // requeueing the older ones immediately
+  bool requeueFailed = false;
+  while (m_lowLatency && !requeueFailed) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 0) <= 0 || (pfd.revents & POLLIN) == 0) break;
+
+    struct v4l2_buffer next;
+    std::memset(&next, 0, sizeof(next));
+    next.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    next.memory = m_memory;
+    if (TryIoctl(fd, VIDIOC_DQBUF, &next) != 0) break;
+    DeviceRecordBuffer(next, wpi::Now());
+    if (m_adaptiveBuffers) DeviceTrackBuffers(next);
+
+    // Never replace a good frame with an errored one
+    bool useNext = (next.flags & V4L2_BUF_FLAG_ERROR) == 0 ||
+                   (buf.flags & V4L2_BUF_FLAG_ERROR) != 0;
+    if (DoIoctl(fd, VIDIOC_QBUF, useNext ? &buf : &next) != 0)
+      requeueFailed = true;
+    if (useNext) {
+      if ((buf.flags & V4L2_BUF_FLAG_ERROR) == 0) ++m_framesSkipped;
+      buf = next;
+    }
+  }
+  if (requeueFailed) {
+    SWARNING("could not requeue buffer");
+    DeviceRecordRequeueFailure();
+    m_wasStreaming = m_streaming;
+    DeviceStreamOff();
+    DeviceDisconnect();
+    m_notified = true;  // device wasn't deleted, just error'ed
+    return;  // will reconnect
+  }
+
+  // In standby, frames are only published at the standby rate
+  bool publish =
+      (buf.flags & V4L2_BUF_FLAG_ERROR) == 0 && DeviceCheckStandby();
+
+  if (publish && m_memory == V4L2_MEMORY_USERPTR) {
+    SDEBUG4("got image size=" << buf.bytesused << " index=" << buf.index);
+
+    if (buf.index >= m_userImages.size() || !m_userImages[buf.index]) {
+      SWARNING("invalid buffer" << buf.index);
+      return;
+    }
+
+    // A fresh pool image is queued in place of the published one
+    if (DevicePutFrameUser(buf)) return;
+  } else if (publish) {
+    SDEBUG4("got image size=" << buf.bytesused << " index=" << buf.index);
+
+    if (buf.index >= m_buffers.size() || !m_buffers[buf.index] ||
+        !m_buffers[buf.index]->m_data) {
+      SWARNING("invalid buffer" << buf.index);
+      return;
+    }
+
+    auto dequeueTime = wpi::Now();
+    auto time = ToFrameTime(buf, dequeueTime);
+    if (ShouldPublishFrame(time)) {
+      // In zero-copy mode the buffer is requeued once the frame is freed
+      if (m_zeroCopy && DevicePutFrameZeroCopy(buf, time, dequeueTime))
+        return;
+
+      auto image = AllocImage(
+          static_cast<VideoMode::PixelFormat>(m_mode.pixelFormat),
+          m_mode.width, m_mode.height, buf.bytesused);
+      std::memcpy(image->data(), m_buffers[buf.index]->m_data, buf.bytesused);
+      PutFrame(std::move(image), time, dequeueTime, buf.sequence);
     }
   }
 
+  // Requeue buffer
+  if (DoIoctl(fd, VIDIOC_QBUF, &buf) != 0) {
+    SWARNING("could not requeue buffer");
+    DeviceRecordRequeueFailure();
+    m_wasStreaming = m_streaming;
+    DeviceStreamOff();
+    DeviceDisconnect();
+    m_notified = true;  // device wasn't deleted, just error'ed
+    return;  // will reconnect
+  }
+}
+
+void UsbCameraImpl::DeviceShutdown() {
   // close camera connection
   DeviceStreamOff();
   DeviceDisconnect();
@@ -429,12 +740,22 @@ void UsbCameraImpl::DeviceDisconnect() {
   int fd = m_fd.exchange(-1);
   if (fd < 0) return;  // already disconnected
 
-  // Unmap buffers
-  for (int i = 0; i < kNumBuffers; ++i)
-    m_buffers[i] = std::move(UsbCameraBuffer{});
+  // Forget buffers; any still held by frames are unmapped when released
+  {
+    std::lock_guard<std::mutex> lock(m_bufferState->mutex);
+    ++m_bufferState->generation;
+    m_bufferState->outstanding.clear();
+    m_bufferState->released.clear();
+  }
+  m_buffers.clear();
+  m_bufferCount = 0;
 
   // Close device
   close(fd);
+  ++m_disconnectCount;
+
+  // The driver no longer references user pointer images
+  m_userImages.clear();
 
   // Notify
   SetConnected(false);
@@ -447,9 +768,11 @@ void UsbCameraImpl::DeviceConnect() {
 
   // Try to open the device
   SDEBUG3("opening device");
+  auto start = wpi::Now();
   int fd = open(m_path.c_str(), O_RDWR);
   if (fd < 0) return;
   m_fd = fd;
+  auto opened = wpi::Now();
 
   // Get capabilities
   SDEBUG3("getting capabilities");
@@ -461,11 +784,46 @@ void UsbCameraImpl::DeviceConnect() {
       m_capabilities = vcap.device_caps;
   }
 
+  // Update description (as it may have changed) and quirks settings.  The
+  // quirks must be known before properties are cached, as they affect
+  // percentage conversion.
+  std::string desc;
+  if (!GetDescriptionSysfs(m_path.c_str(), &desc))
+    desc = GetDescriptionCard(vcap);
+  SetDescription(desc);
+  SetQuirks();
+  auto described = wpi::Now();
+
   // Get or restore video mode
-  if (!m_properties_cached) {
+  bool caching = !m_properties_cached;
+  Frame::Time propertiesCached = 0;
+  Frame::Time modesCached = 0;
+  if (caching) {
+    // Use the capability cache if enabled and this camera has been seen
+    // before; it's checked against the device once startup is done
+    auto& cache = UsbCameraCache::GetInstance();
+    UsbCameraCache::Entry entry;
+    m_capabilityKey.clear();
+    if (cache.IsEnabled())
+      m_capabilityKey = GetCapabilityCacheKey(m_path.c_str(), vcap);
+    bool cached =
+        !m_capabilityKey.empty() && cache.Get(m_capabilityKey, &entry);
+    if (cached) {
+      SDEBUG3("using cached capabilities");
+      m_validateCapabilities = true;
+    }
+
     SDEBUG3("caching properties");
-    DeviceCacheProperties();
-    DeviceCacheVideoModes();
+    if (!cached) DeviceEnumerateControls(fd, &entry.controls);
+    DeviceCacheProperties(entry.controls);
+    DeviceCacheBufferCountProperty();
+    propertiesCached = wpi::Now();
+    if (!cached) {
+      DeviceEnumerateVideoModes(fd, &entry.modes);
+      if (!m_capabilityKey.empty()) cache.Put(m_capabilityKey, entry);
+    }
+    DeviceCacheVideoModes(std::move(entry.modes));
+    modesCached = wpi::Now();
     DeviceCacheMode();
     m_properties_cached = true;
   } else {
@@ -479,64 +837,176 @@ void UsbCameraImpl::DeviceConnect() {
     for (std::size_t i = 0; i < m_propertyData.size(); ++i) {
       const auto prop =
           static_cast<const UsbCameraProperty*>(m_propertyData[i].get());
-      if (!prop || !prop->valueSet || prop->percentage) continue;
+      if (!prop || !prop->valueSet || prop->percentage || prop->id == 0)
+        continue;
       if (!prop->DeviceSet(lock2, m_fd))
         SWARNING("failed to set property " << prop->name);
     }
   }
 
-  // Request buffers
+  if (!DeviceAllocBuffers()) {
+    m_buffers.clear();
+    m_userImages.clear();
+    close(fd);
+    m_fd = -1;
+    return;
+  }
+
+  auto now = wpi::Now();
+  if (caching) {
+    SINFO("opened in " << (now - start) / 10000 << " ms (open "
+                       << (opened - start) / 10000 << " ms, description "
+                       << (described - opened) / 10000 << " ms, controls "
+                       << (propertiesCached - described) / 10000
+                       << " ms, modes "
+                       << (modesCached - propertiesCached) / 10000 << " ms)");
+  } else {
+    SDEBUG("reconnected in " << (now - start) / 10000 << " ms");
+  }
+  if (m_lost) {
+    StatAdd(m_stats.reconnects, 1);
+    m_lost = false;
+  }
+
+  // Notify
+  SetConnected(true);
+}
+
+bool UsbCameraImpl::DeviceAllocBuffers() {
+  int fd = m_fd.load();
+  if (fd < 0) return false;
+
+  // Request buffers.  User pointer buffers need the image size up front so
+  // pool images can be allocated large enough.
   SDEBUG3("allocating buffers");
   struct v4l2_requestbuffers rb;
   std::memset(&rb, 0, sizeof(rb));
-  rb.count = kNumBuffers;
+  rb.count = m_bufferCountTarget;
   rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  rb.memory = V4L2_MEMORY_MMAP;
-  if (DoIoctl(fd, VIDIOC_REQBUFS, &rb) != 0) {
-    SWARNING("could not allocate buffers");
-    close(fd);
-    m_fd = -1;
-    return;
+  m_memory = V4L2_MEMORY_MMAP;
+  if (m_userBuffers) {
+    struct v4l2_format vfmt;
+    std::memset(&vfmt, 0, sizeof(vfmt));
+    vfmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    rb.memory = V4L2_MEMORY_USERPTR;
+    if (DoIoctl(fd, VIDIOC_G_FMT, &vfmt) == 0 && vfmt.fmt.pix.sizeimage > 0 &&
+        TryIoctl(fd, VIDIOC_REQBUFS, &rb) == 0) {
+      m_memory = V4L2_MEMORY_USERPTR;
+      m_userBufferSize = vfmt.fmt.pix.sizeimage;
+      SDEBUG3("using user pointer buffers of size " << m_userBufferSize);
+    } else {
+      SINFO("user pointer buffers not supported; using mmap buffers");
+      rb.count = m_bufferCountTarget;
+    }
   }
 
-  // Map buffers
-  SDEBUG3("mapping buffers");
-  for (int i = 0; i < kNumBuffers; ++i) {
-    struct v4l2_buffer buf;
-    std::memset(&buf, 0, sizeof(buf));
-    buf.index = i;
-    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    buf.memory = V4L2_MEMORY_MMAP;
-    if (DoIoctl(fd, VIDIOC_QUERYBUF, &buf) != 0) {
-      SWARNING("could not query buffer " << i);
-      close(fd);
-      m_fd = -1;
-      return;
+  if (m_memory == V4L2_MEMORY_MMAP) {
+    rb.memory = V4L2_MEMORY_MMAP;
+    if (DoIoctl(fd, VIDIOC_REQBUFS, &rb) != 0 || rb.count == 0) {
+      SWARNING("could not allocate buffers");
+      return false;
     }
-    SDEBUG4("buf " << i << " length=" << buf.length
-                   << " offset=" << buf.m.offset);
-
-    m_buffers[i] = std::move(UsbCameraBuffer(fd, buf.length, buf.m.offset));
-    if (!m_buffers[i].m_data) {
-      SWARNING("could not map buffer " << i);
-      // release other buffers
-      for (int j = 0; j < i; ++j) m_buffers[j] = std::move(UsbCameraBuffer{});
-      close(fd);
-      m_fd = -1;
-      return;
+
+    // Map buffers
+    SDEBUG3("mapping " << rb.count << " buffers");
+    m_buffers.resize(rb.count);
+    for (unsigned i = 0; i < rb.count; ++i) {
+      struct v4l2_buffer buf;
+      std::memset(&buf, 0, sizeof(buf));
+      buf.index = i;
+      buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buf.memory = V4L2_MEMORY_MMAP;
+      if (DoIoctl(fd, VIDIOC_QUERYBUF, &buf) != 0) {
+        SWARNING("could not query buffer " << i);
+        return false;
+      }
+      SDEBUG4("buf " << i << " length=" << buf.length
+                     << " offset=" << buf.m.offset);
+
+      m_buffers[i] =
+          std::make_shared<UsbCameraBuffer>(fd, buf.length, buf.m.offset);
+      if (!m_buffers[i]->m_data) {
+        SWARNING("could not map buffer " << i);
+        return false;
+      }
+
+      SDEBUG4("buf " << i << " address=" << m_buffers[i]->m_data);
     }
+  } else {
+    m_userImages.resize(rb.count);
+  }
 
-    SDEBUG4("buf " << i << " address=" << m_buffers[i].m_data);
+  // The driver may have adjusted the count
+  m_bufferCount = rb.count;
+  {
+    std::lock_guard<std::mutex> lock(m_bufferState->mutex);
+    m_bufferState->outstanding.assign(rb.count, false);
   }
+  return true;
+}
 
-  // Update description (as it may have changed)
-  SetDescription(GetDescriptionImpl(m_path.c_str()));
+bool UsbCameraImpl::DeviceFreeBuffers() {
+  int fd = m_fd.load();
+  if (fd < 0) return false;
 
-  // Update quirks settings
-  SetQuirks();
+  // Mappings still held by zero-copy frames keep the driver buffers busy.
+  // The source itself always holds the last published frame, so copy its
+  // frames first; only frames taken by sinks can prevent freeing.
+  CopyExternalFrames();
+  {
+    std::lock_guard<std::mutex> lock(m_bufferState->mutex);
+    for (bool held : m_bufferState->outstanding) {
+      if (held) return false;
+    }
+    ++m_bufferState->generation;
+    m_bufferState->outstanding.clear();
+    m_bufferState->released.clear();
+  }
+  m_buffers.clear();
+  m_userImages.clear();
+  m_bufferCount = 0;
 
-  // Notify
-  SetConnected(true);
+  struct v4l2_requestbuffers rb;
+  std::memset(&rb, 0, sizeof(rb));
+  rb.count = 0;
+  rb.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  rb.memory = m_memory;
+  if (TryIoctl(fd, VIDIOC_REQBUFS, &rb) != 0) {
+    SDEBUG("could not free buffers: " << std::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+// Reallocates the driver buffers (setting the current mode first if
+// setMode), restarting streaming if it was on.  This is done on the open fd
+// when possible; otherwise (e.g. zero-copy frames still hold buffers) falls
+// back to reconnecting.  Returns true if done in place.
+bool UsbCameraImpl::DeviceReallocBuffers(bool setMode) {
+  if (m_fd < 0) return false;
+  bool wasStreaming = m_streaming;
+  if (wasStreaming) DeviceStreamOff();
+  if (!m_streaming && DeviceFreeBuffers()) {
+    if (setMode) {
+      DeviceSetMode();
+      DeviceSetFPS();
+    }
+    if (DeviceAllocBuffers()) {
+      m_adaptWindowStart = 0;
+      m_adaptHaveSequence = false;
+      if (!wasStreaming || DeviceStreamOn()) return true;
+    }
+  }
+
+  SINFO("could not reallocate buffers in place (zero-copy frames in use?); "
+        "reconnecting");
+  DeviceStreamOff();
+  DeviceDisconnect();
+  DeviceConnect();
+  if (wasStreaming) DeviceStreamOn();
+  m_adaptWindowStart = 0;
+  m_adaptHaveSequence = false;
+  return false;
 }
 
 bool UsbCameraImpl::DeviceStreamOn() {
@@ -544,9 +1014,21 @@ bool UsbCameraImpl::DeviceStreamOn() {
   int fd = m_fd.load();
   if (fd < 0) return false;
 
-  // Queue buffers
+  // Queue buffers, except those still held by zero-copy frames; they are
+  // queued when released.
   SDEBUG3("queuing buffers");
-  for (int i = 0; i < kNumBuffers; ++i) {
+  std::vector<bool> outstanding;
+  {
+    std::lock_guard<std::mutex> lock(m_bufferState->mutex);
+    outstanding = m_bufferState->outstanding;
+    m_bufferState->released.clear();
+  }
+  for (int i = 0, count = m_bufferCount; i < count; ++i) {
+    if (m_memory == V4L2_MEMORY_USERPTR) {
+      if (!DeviceQueueUserBuffer(i)) return false;
+      continue;
+    }
+    if (outstanding[i]) continue;
     struct v4l2_buffer buf;
     std::memset(&buf, 0, sizeof(buf));
     buf.index = i;
@@ -575,6 +1057,243 @@ bool UsbCameraImpl::DeviceStreamOn() {
   }
   SDEBUG4("enabled streaming");
   m_streaming = true;
+  m_statsHaveSequence = false;
+  m_statsLastCapture = 0;
+  return true;
+}
+
+void UsbCameraImpl::DeviceRequeueBuffers() {
+  std::vector<unsigned> released;
+  {
+    std::lock_guard<std::mutex> lock(m_bufferState->mutex);
+    if (m_bufferState->released.empty()) return;
+    released.swap(m_bufferState->released);
+  }
+
+  // If not streaming, DeviceStreamOn() will queue them
+  int fd = m_fd.load();
+  if (!m_streaming || fd < 0) return;
+
+  for (auto index : released) {
+    struct v4l2_buffer buf;
+    std::memset(&buf, 0, sizeof(buf));
+    buf.index = index;
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (DoIoctl(fd, VIDIOC_QBUF, &buf) != 0) {
+      SWARNING("could not requeue buffer " << index);
+      StatAdd(m_stats.requeueFailures, 1);
+    }
+  }
+}
+
+bool UsbCameraImpl::DevicePutFrameZeroCopy(const struct v4l2_buffer& buf,
+                                           Frame::Time time,
+                                           Frame::Time dequeueTime) {
+  auto state = m_bufferState;
+  unsigned index = buf.index;
+  unsigned generation;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    // Count buffers not queued to the driver, including this one
+    int notQueued = 1 + state->released.size();
+    for (bool held : state->outstanding) {
+      if (held) ++notQueued;
+    }
+    if (static_cast<int>(state->outstanding.size()) - notQueued <
+        kMinQueuedBuffers)
+      return false;
+    state->outstanding[index] = true;
+    generation = state->generation;
+  }
+
+  // The release function holds the mapping so it survives a disconnect
+  auto mapping = m_buffers[index];
+  std::unique_ptr<Image> image{new Image{
+      static_cast<char*>(mapping->m_data), buf.bytesused,
+      [state, mapping, index, generation] {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (state->generation != generation) return;  // buffers were freed
+        state->outstanding[index] = false;
+        state->released.push_back(index);
+        if (state->wakeFd >= 0) eventfd_write(state->wakeFd, 1);
+      }}};
+  image->pixelFormat = static_cast<VideoMode::PixelFormat>(m_mode.pixelFormat);
+  image->width = m_mode.width;
+  image->height = m_mode.height;
+  PutFrame(std::move(image), time, dequeueTime, buf.sequence);
+  return true;
+}
+
+void UsbCameraImpl::DeviceTrackBuffers(const struct v4l2_buffer& buf) {
+  auto now = wpi::Now();
+  if (m_adaptWindowStart == 0) m_adaptWindowStart = now;
+
+  // Sequence gaps are frames the driver dropped for lack of a free buffer
+  if (m_adaptHaveSequence && buf.sequence > m_adaptLastSequence + 1)
+    m_adaptDrops += buf.sequence - m_adaptLastSequence - 1;
+  m_adaptLastSequence = buf.sequence;
+  m_adaptHaveSequence = true;
+
+  // Frames waiting more than two intervals are stale; extra buffers above
+  // the requested count only make them staler
+  int fps = m_mode.fps > 0 ? m_mode.fps : 30;
+  uint64_t interval = 10000000 / fps;
+  uint64_t age;
+  if (GetCaptureAge(buf, &age) && age > 2 * interval) ++m_adaptStale;
+  ++m_adaptFrames;
+
+  if (now - m_adaptWindowStart < kBufferAdaptWindow) return;
+
+  int target = m_bufferCountTarget;
+  if (m_adaptDrops > 0) {
+    m_adaptCalmWindows = 0;
+    if (target < kMaxNumBuffers) ++target;
+  } else if (m_adaptStale > m_adaptFrames / 2) {
+    m_adaptCalmWindows = 0;
+    if (target > m_bufferCountSetting) --target;
+  } else if (++m_adaptCalmWindows >= kBufferAdaptCalmWindows) {
+    m_adaptCalmWindows = 0;
+    if (target > m_bufferCountSetting) --target;
+  }
+  SDEBUG4("buffer window: frames=" << m_adaptFrames << " drops="
+                                   << m_adaptDrops << " stale="
+                                   << m_adaptStale);
+
+  m_adaptWindowStart = now;
+  m_adaptFrames = 0;
+  m_adaptDrops = 0;
+  m_adaptStale = 0;
+
+  if (target != m_bufferCountTarget) {
+    m_bufferCountTarget = target;
+    m_bufferCountChanged = true;
+  }
+}
+
+void UsbCameraImpl::DeviceRecordBuffer(const struct v4l2_buffer& buf,
+                                       Frame::Time dequeueTime) {
+  // Sequence gaps are frames the driver dropped
+  int lost = 0;
+  if (m_statsHaveSequence && buf.sequence > m_statsLastSequence + 1) {
+    lost = buf.sequence - m_statsLastSequence - 1;
+    StatAdd(m_stats.framesDropped, lost);
+  }
+  m_statsLastSequence = buf.sequence;
+  m_statsHaveSequence = true;
+
+  if ((buf.flags & V4L2_BUF_FLAG_ERROR) != 0) {
+    StatAdd(m_stats.errorBuffers, 1);
+    ++lost;
+  } else {
+    StatAdd(m_stats.framesCaptured, 1);
+
+    // Lateness is only known if the driver timestamped the buffer.  Use the
+    // raw timestamp; ToFrameTime() discards old (i.e. very late) ones.
+    uint64_t lateness;
+    Frame::Time time = dequeueTime;
+    if (GetCaptureAge(buf, &lateness)) {
+      time = dequeueTime - lateness;
+      StatAdd(m_stats.latenessCount, 1);
+      StatAdd(m_stats.latenessTotal, lateness);
+      StatMax(m_stats.latenessMax, lateness);
+    }
+
+    if (m_statsLastCapture != 0 && time > m_statsLastCapture) {
+      uint64_t interval = time - m_statsLastCapture;
+      if (m_stats.intervalCount.load(std::memory_order_relaxed) == 0 ||
+          interval < m_stats.intervalMin.load(std::memory_order_relaxed))
+        m_stats.intervalMin.store(interval, std::memory_order_relaxed);
+      StatMax(m_stats.intervalMax, interval);
+      StatAdd(m_stats.intervalTotal, interval);
+      StatAdd(m_stats.intervalCount, 1);
+    }
+    m_statsLastCapture = time;
+  }
+
+  // Report lost frames, at most once per interval
+  m_statsUnreported += lost;
+  if (m_statsUnreported > 0 &&
+      dequeueTime - m_statsLastReport >= kFramesDroppedNotifyInterval) {
+    SDEBUG(m_statsUnreported << " frame(s) lost");
+    Notifier::GetInstance().NotifySourceFramesDropped(*this,
+                                                      m_statsUnreported);
+    m_statsUnreported = 0;
+    m_statsLastReport = dequeueTime;
+  }
+}
+
+void UsbCameraImpl::DeviceRecordRequeueFailure() {
+  StatAdd(m_stats.requeueFailures, 1);
+  m_lost = true;  // the caller disconnects
+}
+
+void UsbCameraImpl::GetStats(CS_UsbCameraStats* stats) const {
+  stats->framesCaptured = m_stats.framesCaptured;
+  stats->framesDropped = m_stats.framesDropped;
+  stats->framesSkipped = m_framesSkipped;
+  stats->errorBuffers = m_stats.errorBuffers;
+  stats->requeueFailures = m_stats.requeueFailures;
+  stats->reconnects = m_stats.reconnects;
+  stats->intervalCount = m_stats.intervalCount;
+  stats->intervalTotal = m_stats.intervalTotal;
+  stats->intervalMin = m_stats.intervalMin;
+  stats->intervalMax = m_stats.intervalMax;
+  stats->latenessCount = m_stats.latenessCount;
+  stats->latenessTotal = m_stats.latenessTotal;
+  stats->latenessMax = m_stats.latenessMax;
+}
+
+void UsbCameraImpl::DeviceReconnect() {
+  bool wasStreaming = m_streaming;
+  if (wasStreaming) DeviceStreamOff();
+  if (m_fd >= 0) {
+    DeviceDisconnect();
+    DeviceConnect();
+  }
+  if (wasStreaming) DeviceStreamOn();
+  m_adaptWindowStart = 0;
+  m_adaptHaveSequence = false;
+}
+
+bool UsbCameraImpl::DeviceQueueUserBuffer(unsigned index) {
+  int fd = m_fd.load();
+  if (fd < 0) return false;
+
+  auto& image = m_userImages[index];
+  if (!image) {
+    image = AllocImage(static_cast<VideoMode::PixelFormat>(m_mode.pixelFormat),
+                       m_mode.width, m_mode.height, m_userBufferSize);
+  }
+
+  struct v4l2_buffer buf;
+  std::memset(&buf, 0, sizeof(buf));
+  buf.index = index;
+  buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  buf.memory = V4L2_MEMORY_USERPTR;
+  buf.m.userptr = reinterpret_cast<unsigned long>(image->data());
+  buf.length = m_userBufferSize;
+  if (DoIoctl(fd, VIDIOC_QBUF, &buf) != 0) {
+    SWARNING("could not queue buffer " << index);
+    return false;
+  }
+  return true;
+}
+
+bool UsbCameraImpl::DevicePutFrameUser(const struct v4l2_buffer& buf) {
+  auto dequeueTime = wpi::Now();
+  auto time = ToFrameTime(buf, dequeueTime);
+  if (!ShouldPublishFrame(time)) return false;
+
+  auto image = std::move(m_userImages[buf.index]);
+  if (!DeviceQueueUserBuffer(buf.index)) {
+    // Requeue the filled image instead
+    m_userImages[buf.index] = std::move(image);
+    return false;
+  }
+
+  image->SetSize(buf.bytesused);
+  PutFrame(std::move(image), time, dequeueTime, buf.sequence);
   return true;
 }
 
@@ -615,29 +1334,34 @@ CS_StatusValue UsbCameraImpl::DeviceCmdSetMode(
     m_modeSetFPS = true;
   }
 
-  // If the pixel format or resolution changed, we need to disconnect and
-  // reconnect
+  // If the pixel format or resolution changed, the buffers need to be
+  // reallocated.  This is done on the open fd when possible; otherwise
+  // (e.g. zero-copy frames still hold buffers) fall back to reconnecting.
   if (newMode.pixelFormat != m_mode.pixelFormat ||
       newMode.width != m_mode.width || newMode.height != m_mode.height) {
     m_mode = newMode;
     lock.unlock();
-    bool wasStreaming = m_streaming;
-    if (wasStreaming) DeviceStreamOff();
-    if (m_fd >= 0) {
-      DeviceDisconnect();
-      DeviceConnect();
-    }
-    if (wasStreaming) DeviceStreamOn();
+    auto start = wpi::Now();
+    bool fast = DeviceReallocBuffers(true);
+    SINFO("switched mode" << (fast ? "" : " by reconnecting") << " in "
+                          << (wpi::Now() - start) / 10000 << " ms");
+    if (m_streaming) m_modeSwitchStart = start;
     Notifier::GetInstance().NotifySourceVideoMode(*this, newMode);
     lock.lock();
   } else if (newMode.fps != m_mode.fps) {
     m_mode = newMode;
     lock.unlock();
-    // Need to stop streaming to set FPS
-    bool wasStreaming = m_streaming;
-    if (wasStreaming) DeviceStreamOff();
-    DeviceSetFPS();
-    if (wasStreaming) DeviceStreamOn();
+    // Some drivers accept a new frame interval while streaming; others need
+    // streaming stopped to set FPS
+    auto start = wpi::Now();
+    if (!m_streaming || !DeviceSetFPS(false)) {
+      bool wasStreaming = m_streaming;
+      if (wasStreaming) DeviceStreamOff();
+      DeviceSetFPS();
+      if (wasStreaming) DeviceStreamOn();
+    }
+    SINFO("switched FPS in " << (wpi::Now() - start) / 10000 << " ms");
+    if (m_streaming) m_modeSwitchStart = start;
     Notifier::GetInstance().NotifySourceVideoMode(*this, newMode);
     lock.lock();
   }
@@ -645,13 +1369,9 @@ CS_StatusValue UsbCameraImpl::DeviceCmdSetMode(
   return CS_OK;
 }
 
-CS_StatusValue UsbCameraImpl::DeviceCmdSetProperty(
-    std::unique_lock<std::mutex>& lock, const Message& msg) {
-  bool setString = (msg.kind == Message::kCmdSetPropertyStr);
-  int property = msg.data[0];
-  int value = msg.data[1];
-  llvm::StringRef valueStr = msg.dataStr;
-
+CS_StatusValue UsbCameraImpl::DeviceCheckPropertyWrite(int property, int value,
+                                                      bool setString,
+                                                      PropertyWrite* write) {
   // Look up
   auto prop = static_cast<UsbCameraProperty*>(GetProperty(property));
   if (!prop) return CS_INVALID_PROPERTY;
@@ -671,8 +1391,11 @@ CS_StatusValue UsbCameraImpl::DeviceCmdSetProperty(
            0))
     return CS_WRONG_PROPERTY_TYPE;
 
+  // Buffer count is a driver setting rather than a control
+  write->bufferCount = prop->name == kPropBufferCount;
+
   // Handle percentage property
-  int percentageProperty = prop->propPair;
+  int percentageProperty = write->bufferCount ? 0 : prop->propPair;
   int percentageValue = value;
   if (percentageProperty != 0) {
     if (prop->percentage) {
@@ -684,16 +1407,103 @@ CS_StatusValue UsbCameraImpl::DeviceCmdSetProperty(
     }
   }
 
+  write->prop = prop;
+  write->property = property;
+  write->value = value;
+  write->percentageProperty = percentageProperty;
+  write->percentageValue = percentageValue;
+  return CS_OK;
+}
+
+CS_StatusValue UsbCameraImpl::DeviceCmdSetProperty(
+    std::unique_lock<std::mutex>& lock, const Message& msg) {
+  bool setString = (msg.kind == Message::kCmdSetPropertyStr);
+  llvm::StringRef valueStr = msg.dataStr;
+
+  PropertyWrite write;
+  auto rv = DeviceCheckPropertyWrite(msg.data[0], msg.data[1], setString,
+                                     &write);
+  if (rv != CS_OK) return rv;
+  if (write.bufferCount)
+    return DeviceCmdSetBufferCount(lock, write.property, write.value);
+
   // Actually set the new value on the device (if possible)
-  if (!prop->DeviceSet(lock, m_fd, value, valueStr))
+  if (!write.prop->DeviceSet(lock, m_fd, write.value, valueStr))
     return CS_PROPERTY_WRITE_FAILED;
 
   // Cache the set values
-  UpdatePropertyValue(property, setString, value, valueStr);
-  if (percentageProperty != 0)
-    UpdatePropertyValue(percentageProperty, setString, percentageValue,
-                        valueStr);
+  UpdatePropertyValue(write.property, setString, write.value, valueStr);
+  if (write.percentageProperty != 0)
+    UpdatePropertyValue(write.percentageProperty, setString,
+                        write.percentageValue, valueStr);
+
+  return CS_OK;
+}
+
+CS_StatusValue UsbCameraImpl::DeviceCmdSetProperties(
+    std::unique_lock<std::mutex>& lock, const Message& msg) {
+  llvm::SmallVector<PropertyWrite, 16> writes;
+  llvm::SmallVector<const UsbCameraProperty*, 16> props;
+  llvm::SmallVector<int, 16> values;
+  PropertyWrite bufferCount{};
+
+  // Check everything before writing anything
+  for (auto& pv : msg.dataProps) {
+    PropertyWrite write;
+    auto rv = DeviceCheckPropertyWrite(pv.first, pv.second, false, &write);
+    if (rv != CS_OK) return rv;
+    if (write.bufferCount) {
+      bufferCount = write;
+      continue;
+    }
+    writes.push_back(write);
+    props.push_back(write.prop);
+    values.push_back(write.value);
+  }
+
+  // Set the new values on the device in as few calls as possible
+  llvm::SmallVector<bool, 16> ok;
+  UsbCameraProperty::DeviceSetMultiple(lock, m_fd, props, values, ok);
+
+  // Cache the set values
+  CS_StatusValue status = CS_OK;
+  for (std::size_t i = 0; i < writes.size(); ++i) {
+    if (!ok[i]) {
+      SWARNING("failed to set property " << props[i]->name);
+      status = CS_PROPERTY_WRITE_FAILED;
+      continue;
+    }
+    UpdatePropertyValue(writes[i].property, false, values[i],
+                        llvm::StringRef{});
+    if (writes[i].percentageProperty != 0)
+      UpdatePropertyValue(writes[i].percentageProperty, false,
+                          writes[i].percentageValue, llvm::StringRef{});
+  }
+
+  if (bufferCount.bufferCount) {
+    auto rv =
+        DeviceCmdSetBufferCount(lock, bufferCount.property, bufferCount.value);
+    if (rv != CS_OK) status = rv;
+  }
+  return status;
+}
+
+CS_StatusValue UsbCameraImpl::DeviceCmdSetBufferCount(
+    std::unique_lock<std::mutex>& lock, int property, int count) {
+  if (count < kMinNumBuffers)
+    count = kMinNumBuffers;
+  else if (count > kMaxNumBuffers)
+    count = kMaxNumBuffers;
+  UpdatePropertyValue(property, false, count, llvm::StringRef{});
+
+  if (count == m_bufferCountSetting) return CS_OK;
+  m_bufferCountSetting = count;
+  m_bufferCountTarget = count;
 
+  // Reallocate the buffers to apply it
+  lock.unlock();
+  DeviceReallocBuffers(false);
+  lock.lock();
   return CS_OK;
 }
 
@@ -707,25 +1517,72 @@ CS_StatusValue UsbCameraImpl::DeviceProcessCommand(
   } else if (msg.kind == Message::kCmdSetProperty ||
              msg.kind == Message::kCmdSetPropertyStr) {
     return DeviceCmdSetProperty(lock, msg);
+  } else if (msg.kind == Message::kCmdSetProperties) {
+    return DeviceCmdSetProperties(lock, msg);
+  } else if (msg.kind == Message::kCmdSetUserBuffers) {
+    bool enabled = msg.data[0] != 0;
+    if (enabled == m_userBuffers) return CS_OK;
+    m_userBuffers = enabled;
+    // Buffer type is chosen on connect, so reconnect to apply it
+    lock.unlock();
+    DeviceReconnect();
+    lock.lock();
+    return CS_OK;
   } else if (msg.kind == Message::kNumSinksChanged ||
-             msg.kind == Message::kNumSinksEnabledChanged) {
+             msg.kind == Message::kNumSinksEnabledChanged ||
+             msg.kind == Message::kConversionHintsChanged ||
+             msg.kind == Message::kCapabilitiesChecked) {
     return CS_OK;
   } else {
     return CS_OK;
   }
 }
 
+static bool IsPropertyWrite(const UsbCameraImpl::Message& msg) {
+  return msg.kind == UsbCameraImpl::Message::kCmdSetProperty ||
+         msg.kind == UsbCameraImpl::Message::kCmdSetPropertyStr;
+}
+
 void UsbCameraImpl::DeviceProcessCommands() {
   std::unique_lock<std::mutex> lock(m_mutex);
   if (m_commands.empty()) return;
+  std::vector<Message> batch;
   while (!m_commands.empty()) {
-    auto msg = std::move(m_commands.back());
-    m_commands.pop_back();
+    // Process in the order sent.  Commands sent while this batch is being
+    // processed (the lock is released during ioctls) form the next batch.
+    batch.clear();
+    batch.swap(m_commands);
+
+    // A write to a property that is written again later in the batch is
+    // skipped, so only the latest value reaches the device; its sender gets
+    // the status of the later write.
+    std::vector<std::size_t> superseded;
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+      const Message& msg = batch[i];
+      if (IsPropertyWrite(msg) &&
+          std::any_of(batch.begin() + i + 1, batch.end(),
+                      [&](const Message& later) {
+                        return later.kind == msg.kind &&
+                               later.data[0] == msg.data[0];
+                      })) {
+        superseded.push_back(i);
+        continue;
+      }
 
-    CS_StatusValue status = DeviceProcessCommand(lock, msg);
-    if (msg.kind != Message::kNumSinksChanged &&
-        msg.kind != Message::kNumSinksEnabledChanged)
-      m_responses.emplace_back(msg.from, status);
+      CS_StatusValue status = DeviceProcessCommand(lock, msg);
+      if (msg.kind != Message::kNumSinksChanged &&
+          msg.kind != Message::kNumSinksEnabledChanged &&
+          msg.kind != Message::kConversionHintsChanged &&
+          msg.kind != Message::kCapabilitiesChecked)
+        m_responses.emplace_back(msg.from, status);
+
+      if (IsPropertyWrite(msg)) {
+        for (auto j : superseded) {
+          if (batch[j].kind == msg.kind && batch[j].data[0] == msg.data[0])
+            m_responses.emplace_back(batch[j].from, status);
+        }
+      }
+    }
   }
   lock.unlock();
   m_responseCv.notify_all();
@@ -762,22 +1619,26 @@ void UsbCameraImpl::DeviceSetMode() {
   }
 }
 
-void UsbCameraImpl::DeviceSetFPS() {
+bool UsbCameraImpl::DeviceSetFPS(bool warn) {
   int fd = m_fd.load();
-  if (fd < 0) return;
+  if (fd < 0) return false;
 
   struct v4l2_streamparm parm;
   std::memset(&parm, 0, sizeof(parm));
   parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-  if (DoIoctl(fd, VIDIOC_G_PARM, &parm) != 0) return;
-  if ((parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME) == 0) return;
+  if (DoIoctl(fd, VIDIOC_G_PARM, &parm) != 0) return false;
+  if ((parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME) == 0)
+    return false;
   std::memset(&parm, 0, sizeof(parm));
   parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
   parm.parm.capture.timeperframe = FPSToFract(m_mode.fps);
-  if (DoIoctl(fd, VIDIOC_S_PARM, &parm) != 0)
-    SWARNING("could not set FPS to " << m_mode.fps);
-  else
-    SINFO("set FPS to " << m_mode.fps);
+  if ((warn ? DoIoctl(fd, VIDIOC_S_PARM, &parm)
+            : TryIoctl(fd, VIDIOC_S_PARM, &parm)) != 0) {
+    if (warn) SWARNING("could not set FPS to " << m_mode.fps);
+    return false;
+  }
+  SINFO("set FPS to " << m_mode.fps);
+  return true;
 }
 
 void UsbCameraImpl::DeviceCacheMode() {
@@ -931,8 +1792,8 @@ void UsbCameraImpl::DeviceCacheProperty(
     }
   }
 
-  // Set value on device if user-configured
-  if (rawProp->valueSet) {
+  // Set value on device if user-configured (id 0 is not a device control)
+  if (rawProp->valueSet && rawProp->id != 0) {
     if (!rawProp->DeviceSet(lock, m_fd))
       SWARNING("failed to set property " << rawProp->name);
   }
@@ -977,8 +1838,8 @@ void UsbCameraImpl::DeviceCacheProperty(
   if (perPropPtr) NotifyPropertyCreated(*perIndex, *perPropPtr);
 }
 
-void UsbCameraImpl::DeviceCacheProperties() {
-  int fd = m_fd.load();
+void UsbCameraImpl::DeviceEnumerateControls(
+    int fd, std::vector<UsbCameraCache::Control>* controls) {
   if (fd < 0) return;
 
   constexpr __u32 nextFlags = V4L2_CTRL_FLAG_NEXT_CTRL
@@ -989,30 +1850,46 @@ void UsbCameraImpl::DeviceCacheProperties() {
   __u32 id = nextFlags;
 
   while (auto prop = UsbCameraProperty::DeviceQuery(fd, &id)) {
-    DeviceCacheProperty(std::move(prop));
+    controls->emplace_back(*prop);
     id |= nextFlags;
   }
 
-  if (id == nextFlags) {
-    // try just enumerating standard...
-    for (id = V4L2_CID_BASE; id < V4L2_CID_LASTP1; ++id) {
-      if (auto prop = UsbCameraProperty::DeviceQuery(fd, &id))
-        DeviceCacheProperty(std::move(prop));
-    }
-    // ... and custom controls
-    std::unique_ptr<UsbCameraProperty> prop;
-    for (id = V4L2_CID_PRIVATE_BASE;
-         (prop = UsbCameraProperty::DeviceQuery(fd, &id)); ++id)
-      DeviceCacheProperty(std::move(prop));
+  // Drivers without NEXT_CTRL support (pre-2.6.18 kernels) are not probed
+  // id by id; that costs an ioctl per possible control on every camera
+  // without controls.
+}
+
+void UsbCameraImpl::DeviceCacheProperties(
+    const std::vector<UsbCameraCache::Control>& controls) {
+  for (const auto& control : controls)
+    DeviceCacheProperty(control.ToProperty());
+}
+
+void UsbCameraImpl::DeviceCacheBufferCountProperty() {
+  // Buffer count (not a V4L2 control; id is 0)
+  auto bufProp = llvm::make_unique<UsbCameraProperty>(kPropBufferCount);
+  bufProp->propKind = CS_PROP_INTEGER;
+  bufProp->hasMinimum = true;
+  bufProp->minimum = kMinNumBuffers;
+  bufProp->hasMaximum = true;
+  bufProp->maximum = kMaxNumBuffers;
+  bufProp->defaultValue = kDefaultNumBuffers;
+  bufProp->value = kDefaultNumBuffers;
+  DeviceCacheProperty(std::move(bufProp));
+
+  // Pick up a count set before the properties were cached
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto cached = GetProperty(m_properties[kPropBufferCount]);
+  if (cached && cached->valueSet) {
+    m_bufferCountSetting = cached->value;
+    m_bufferCountTarget = cached->value;
   }
 }
 
-void UsbCameraImpl::DeviceCacheVideoModes() {
-  int fd = m_fd.load();
+void UsbCameraImpl::DeviceEnumerateVideoModes(int fd,
+                                              std::vector<VideoMode>* modes) {
   if (fd < 0) return;
 
-  std::vector<VideoMode> modes;
-
   // Pixel formats
   struct v4l2_fmtdesc fmt;
   std::memset(&fmt, 0, sizeof(fmt));
@@ -1040,7 +1917,7 @@ void UsbCameraImpl::DeviceCacheVideoModes() {
            ++frmival.index) {
         if (frmival.type != V4L2_FRMIVAL_TYPE_DISCRETE) continue;
 
-        modes.emplace_back(pixelFormat,
+        modes->emplace_back(pixelFormat,
                            static_cast<int>(frmsize.discrete.width),
                            static_cast<int>(frmsize.discrete.height),
                            FractToFPS(frmival.discrete));
@@ -1048,6 +1925,9 @@ void UsbCameraImpl::DeviceCacheVideoModes() {
     }
   }
 
+}
+
+void UsbCameraImpl::DeviceCacheVideoModes(std::vector<VideoMode> modes) {
   {
     std::lock_guard<std::mutex> lock(m_mutex);
     m_videoModes.swap(modes);
@@ -1055,6 +1935,49 @@ void UsbCameraImpl::DeviceCacheVideoModes() {
   Notifier::GetInstance().NotifySource(*this, CS_SOURCE_VIDEOMODES_UPDATED);
 }
 
+void UsbCameraImpl::DeviceValidateCapabilities() {
+  m_validateCapabilities = false;
+  if (m_validateThread.joinable()) return;  // only checked once
+
+  // Enumeration is hundreds of ioctls; do it on a separate fd (V4L2 allows
+  // several opens; only streaming is exclusive) and hand the result back
+  m_validateThread = std::thread([this] {
+    int fd = open(m_path.c_str(), O_RDWR);
+    if (fd < 0) return;
+    UsbCameraCache::Entry entry;
+    DeviceEnumerateControls(fd, &entry.controls);
+    DeviceEnumerateVideoModes(fd, &entry.modes);
+    close(fd);
+    if (!m_active) return;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_checkedCapabilities = std::move(entry);
+    }
+    m_capabilitiesChecked = true;
+    Send(Message{Message::kCapabilitiesChecked});
+  });
+}
+
+void UsbCameraImpl::DeviceApplyCheckedCapabilities() {
+  m_capabilitiesChecked = false;
+  UsbCameraCache::Entry entry;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    entry = std::move(m_checkedCapabilities);
+  }
+  // A device that went away mid-enumeration reports nothing useful
+  if (m_fd < 0 || entry.modes.empty()) return;
+
+  auto& cache = UsbCameraCache::GetInstance();
+  UsbCameraCache::Entry cached;
+  if (cache.Get(m_capabilityKey, &cached) && cached == entry) return;
+
+  SINFO("cached capabilities do not match the device; updating");
+  cache.Put(m_capabilityKey, entry);
+  DeviceCacheProperties(entry.controls);
+  DeviceCacheVideoModes(std::move(entry.modes));
+}
+
 CS_StatusValue UsbCameraImpl::SendAndWait(Message&& msg) const {
   int fd = m_command_fd.load();
   // exit early if not possible to signal
@@ -1135,6 +2058,15 @@ void UsbCameraImpl::SetProperty(int property, int value, CS_Status* status) {
   *status = SendAndWait(std::move(msg));
 }
 
+void UsbCameraImpl::SetProperties(llvm::ArrayRef<int> properties,
+                                  llvm::ArrayRef<int> values,
+                                  CS_Status* status) {
+  Message msg{Message::kCmdSetProperties};
+  for (std::size_t i = 0; i < properties.size(); ++i)
+    msg.dataProps.emplace_back(properties[i], values[i]);
+  *status = SendAndWait(std::move(msg));
+}
+
 void UsbCameraImpl::SetStringProperty(int property, llvm::StringRef value,
                                       CS_Status* status) {
   Message msg{Message::kCmdSetPropertyStr};
@@ -1143,6 +2075,10 @@ void UsbCameraImpl::SetStringProperty(int property, llvm::StringRef value,
   *status = SendAndWait(std::move(msg));
 }
 
+void UsbCameraImpl::SetBufferCount(int count, CS_Status* status) {
+  SetProperty(GetPropertyIndex(kPropBufferCount), count, status);
+}
+
 void UsbCameraImpl::SetBrightness(int brightness, CS_Status* status) {
   if (brightness > 100) {
     brightness = 100;
@@ -1221,6 +2157,13 @@ bool UsbCameraImpl::SetFPS(int fps, CS_Status* status) {
   return *status == CS_OK;
 }
 
+bool UsbCameraImpl::SetUserBuffers(bool enabled, CS_Status* status) {
+  Message msg{Message::kCmdSetUserBuffers};
+  msg.data[0] = enabled;
+  *status = SendAndWait(std::move(msg));
+  return *status == CS_OK;
+}
+
 void UsbCameraImpl::NumSinksChanged() {
   Send(Message{Message::kNumSinksChanged});
 }
@@ -1229,6 +2172,12 @@ void UsbCameraImpl::NumSinksEnabledChanged() {
   Send(Message{Message::kNumSinksEnabledChanged});
 }
 
+void UsbCameraImpl::ConversionHintsChanged() {
+  // Only auto video mode depends on the hints; wake the camera thread so it
+  // reconsiders the mode right away
+  if (GetAutoVideoMode()) Send(Message{Message::kConversionHintsChanged});
+}
+
 namespace cs {
 
 CS_Source CreateUsbCameraDev(llvm::StringRef name, int dev, CS_Status* status) {
@@ -1258,40 +2207,209 @@ std::string GetUsbCameraPath(CS_Source source, CS_Status* status) {
   return static_cast<UsbCameraImpl&>(*data->source).GetPath();
 }
 
-std::vector<UsbCameraInfo> EnumerateUsbCameras(CS_Status* status) {
-  std::vector<UsbCameraInfo> retval;
+void SetUsbCameraZeroCopy(CS_Source source, bool enabled, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  static_cast<UsbCameraImpl&>(*data->source).SetZeroCopy(enabled);
+}
+
+bool GetUsbCameraZeroCopy(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return false;
+  }
+  return static_cast<UsbCameraImpl&>(*data->source).GetZeroCopy();
+}
+
+void SetUsbCameraUserBuffers(CS_Source source, bool enabled,
+                             CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  static_cast<UsbCameraImpl&>(*data->source).SetUserBuffers(enabled, status);
+}
+
+bool GetUsbCameraUserBuffers(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return false;
+  }
+  return static_cast<UsbCameraImpl&>(*data->source).GetUserBuffers();
+}
+
+void SetUsbCameraBufferCount(CS_Source source, int count, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  static_cast<UsbCameraImpl&>(*data->source).SetBufferCount(count, status);
+}
+
+int GetUsbCameraBufferCount(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return static_cast<UsbCameraImpl&>(*data->source).GetBufferCount();
+}
+
+void SetUsbCameraAdaptiveBuffers(CS_Source source, bool enabled,
+                                 CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  static_cast<UsbCameraImpl&>(*data->source).SetAdaptiveBuffers(enabled);
+}
+
+bool GetUsbCameraAdaptiveBuffers(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return false;
+  }
+  return static_cast<UsbCameraImpl&>(*data->source).GetAdaptiveBuffers();
+}
+
+void SetUsbCameraLowLatency(CS_Source source, bool enabled,
+                            CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  static_cast<UsbCameraImpl&>(*data->source).SetLowLatency(enabled);
+}
+
+bool GetUsbCameraLowLatency(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return false;
+  }
+  return static_cast<UsbCameraImpl&>(*data->source).GetLowLatency();
+}
+
+uint64_t GetUsbCameraFramesSkipped(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return static_cast<UsbCameraImpl&>(*data->source).GetFramesSkipped();
+}
+
+void GetUsbCameraStats(CS_Source source, CS_UsbCameraStats* stats,
+                       CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  static_cast<UsbCameraImpl&>(*data->source).GetStats(stats);
+}
+
+void SetUsbCameraLinger(CS_Source source, double seconds, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  static_cast<UsbCameraImpl&>(*data->source).SetLinger(seconds);
+}
+
+double GetUsbCameraLinger(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return static_cast<UsbCameraImpl&>(*data->source).GetLinger();
+}
+
+void SetUsbCameraStandbyFPS(CS_Source source, double fps, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  static_cast<UsbCameraImpl&>(*data->source).SetStandbyFPS(fps);
+}
+
+double GetUsbCameraStandbyFPS(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data || data->kind != CS_SOURCE_USB) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return static_cast<UsbCameraImpl&>(*data->source).GetStandbyFPS();
+}
 
-  if (DIR* dp = opendir("/dev")) {
-    while (struct dirent* ep = readdir(dp)) {
-      llvm::StringRef fname{ep->d_name};
-      if (!fname.startswith("video")) continue;
+void SetUsbCameraCacheFile(llvm::StringRef path) {
+  UsbCameraCache::GetInstance().SetPath(path);
+}
+
+std::string GetUsbCameraCacheFile() {
+  return UsbCameraCache::GetInstance().GetPath();
+}
 
-      UsbCameraInfo info;
-      info.dev = -1;
-      fname.substr(5).getAsInteger(10, info.dev);
-      llvm::SmallString<32> path{"/dev/"};
-      path += fname;
-      info.path = path.str();
+void SetUsbCameraReactorThreads(int numThreads) {
+  UsbCameraReactor::GetInstance().SetNumThreads(numThreads);
+}
 
-      info.name = GetDescriptionImpl(path.c_str());
-      if (info.name.empty()) continue;
+int GetUsbCameraReactorThreads() {
+  return UsbCameraReactor::GetInstance().GetNumThreads();
+}
 
-      retval.emplace_back(std::move(info));
+bool PlanUsbCameraModes(llvm::ArrayRef<CS_Source> sources,
+                        std::vector<VideoMode>* modes, CS_Status* status) {
+  modes->clear();
+  std::vector<UsbBandwidthCamera> cameras;
+  for (auto source : sources) {
+    auto data = Sources::GetInstance().Get(source);
+    if (!data || data->kind != CS_SOURCE_USB) {
+      *status = CS_INVALID_HANDLE;
+      return false;
     }
-    closedir(dp);
-  } else {
-    //*status = ;
-    ERROR("Could not open /dev");
-    return retval;
+    auto& impl = static_cast<UsbCameraImpl&>(*data->source);
+    UsbBandwidthCamera camera;
+    if (!ReadUsbTopology(impl.GetPath(), &camera))
+      DEBUG("could not find USB bus of " << impl.GetPath());
+    // A camera whose mode isn't known (e.g. never connected) can't be
+    // planned
+    CS_Status modeStatus = 0;
+    VideoMode mode = impl.GetVideoMode(&modeStatus);
+    auto supported = impl.EnumerateVideoModes(&modeStatus);
+    if (modeStatus == 0 &&
+        (mode.pixelFormat == VideoMode::kUnknown || mode.width == 0))
+      modeStatus = CS_SOURCE_IS_DISCONNECTED;
+    if (modeStatus != 0) {
+      *status = modeStatus;
+      return false;
+    }
+    camera.candidates = GetUsbModeCandidates(mode, supported);
+    cameras.emplace_back(std::move(camera));
   }
 
-  // sort by device number
-  std::sort(retval.begin(), retval.end(),
-            [](const UsbCameraInfo& a, const UsbCameraInfo& b) {
-              return a.dev < b.dev;
-            });
+  std::vector<std::size_t> choices;
+  bool fits = PlanUsbBandwidth(cameras, &choices);
+  for (std::size_t i = 0; i < cameras.size(); ++i)
+    modes->push_back(cameras[i].candidates[choices[i]]);
+  return fits;
+}
 
-  return retval;
+std::vector<UsbCameraInfo> EnumerateUsbCameras(CS_Status* status) {
+  return UsbCameraRegistry::GetInstance().GetCameras();
 }
 
 }  // namespace cs
@@ -1311,6 +2429,103 @@ char* CS_GetUsbCameraPath(CS_Source source, CS_Status* status) {
   return ConvertToC(cs::GetUsbCameraPath(source, status));
 }
 
+void CS_SetUsbCameraZeroCopy(CS_Source source, CS_Bool enabled,
+                             CS_Status* status) {
+  return cs::SetUsbCameraZeroCopy(source, enabled, status);
+}
+
+CS_Bool CS_GetUsbCameraZeroCopy(CS_Source source, CS_Status* status) {
+  return cs::GetUsbCameraZeroCopy(source, status);
+}
+
+void CS_SetUsbCameraUserBuffers(CS_Source source, CS_Bool enabled,
+                                CS_Status* status) {
+  return cs::SetUsbCameraUserBuffers(source, enabled, status);
+}
+
+CS_Bool CS_GetUsbCameraUserBuffers(CS_Source source, CS_Status* status) {
+  return cs::GetUsbCameraUserBuffers(source, status);
+}
+
+void CS_SetUsbCameraBufferCount(CS_Source source, int count,
+                                CS_Status* status) {
+  return cs::SetUsbCameraBufferCount(source, count, status);
+}
+
+int CS_GetUsbCameraBufferCount(CS_Source source, CS_Status* status) {
+  return cs::GetUsbCameraBufferCount(source, status);
+}
+
+void CS_SetUsbCameraAdaptiveBuffers(CS_Source source, CS_Bool enabled,
+                                    CS_Status* status) {
+  return cs::SetUsbCameraAdaptiveBuffers(source, enabled, status);
+}
+
+CS_Bool CS_GetUsbCameraAdaptiveBuffers(CS_Source source, CS_Status* status) {
+  return cs::GetUsbCameraAdaptiveBuffers(source, status);
+}
+
+void CS_SetUsbCameraLowLatency(CS_Source source, CS_Bool enabled,
+                               CS_Status* status) {
+  return cs::SetUsbCameraLowLatency(source, enabled, status);
+}
+
+CS_Bool CS_GetUsbCameraLowLatency(CS_Source source, CS_Status* status) {
+  return cs::GetUsbCameraLowLatency(source, status);
+}
+
+uint64_t CS_GetUsbCameraFramesSkipped(CS_Source source, CS_Status* status) {
+  return cs::GetUsbCameraFramesSkipped(source, status);
+}
+
+void CS_GetUsbCameraStats(CS_Source source, CS_UsbCameraStats* stats,
+                          CS_Status* status) {
+  return cs::GetUsbCameraStats(source, stats, status);
+}
+
+void CS_SetUsbCameraLinger(CS_Source source, double seconds,
+                           CS_Status* status) {
+  return cs::SetUsbCameraLinger(source, seconds, status);
+}
+
+double CS_GetUsbCameraLinger(CS_Source source, CS_Status* status) {
+  return cs::GetUsbCameraLinger(source, status);
+}
+
+void CS_SetUsbCameraStandbyFPS(CS_Source source, double fps,
+                               CS_Status* status) {
+  return cs::SetUsbCameraStandbyFPS(source, fps, status);
+}
+
+double CS_GetUsbCameraStandbyFPS(CS_Source source, CS_Status* status) {
+  return cs::GetUsbCameraStandbyFPS(source, status);
+}
+
+void CS_SetUsbCameraCacheFile(const char* path) {
+  cs::SetUsbCameraCacheFile(path);
+}
+
+char* CS_GetUsbCameraCacheFile(void) {
+  return cs::ConvertToC(cs::GetUsbCameraCacheFile());
+}
+
+void CS_SetUsbCameraReactorThreads(int numThreads) {
+  cs::SetUsbCameraReactorThreads(numThreads);
+}
+
+int CS_GetUsbCameraReactorThreads(void) {
+  return cs::GetUsbCameraReactorThreads();
+}
+
+CS_Bool CS_PlanUsbCameraModes(const CS_Source* sources, int count,
+                              CS_VideoMode* modes, CS_Status* status) {
+  std::vector<cs::VideoMode> planned;
+  bool fits = cs::PlanUsbCameraModes(
+      llvm::ArrayRef<CS_Source>(sources, count), &planned, status);
+  for (std::size_t i = 0; i < planned.size(); ++i) modes[i] = planned[i];
+  return fits;
+}
+
 CS_UsbCameraInfo* CS_EnumerateUsbCameras(int* count, CS_Status* status) {
   auto cameras = cs::EnumerateUsbCameras(status);
   CS_UsbCameraInfo* out = static_cast<CS_UsbCameraInfo*>(
@@ -1355,6 +2570,100 @@ char* CS_GetUsbCameraPath(CS_Source source, CS_Status* status) {
   return nullptr;
 }
 
+void CS_SetUsbCameraZeroCopy(CS_Source source, CS_Bool enabled,
+                             CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+}
+
+CS_Bool CS_GetUsbCameraZeroCopy(CS_Source source, CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+  return false;
+}
+
+void CS_SetUsbCameraUserBuffers(CS_Source source, CS_Bool enabled,
+                                CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+}
+
+CS_Bool CS_GetUsbCameraUserBuffers(CS_Source source, CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+  return false;
+}
+
+void CS_SetUsbCameraBufferCount(CS_Source source, int count,
+                                CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+}
+
+int CS_GetUsbCameraBufferCount(CS_Source source, CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+  return 0;
+}
+
+void CS_SetUsbCameraAdaptiveBuffers(CS_Source source, CS_Bool enabled,
+                                    CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+}
+
+CS_Bool CS_GetUsbCameraAdaptiveBuffers(CS_Source source, CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+  return false;
+}
+
+void CS_SetUsbCameraLowLatency(CS_Source source, CS_Bool enabled,
+                               CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+}
+
+CS_Bool CS_GetUsbCameraLowLatency(CS_Source source, CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+  return false;
+}
+
+uint64_t CS_GetUsbCameraFramesSkipped(CS_Source source, CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+  return 0;
+}
+
+void CS_GetUsbCameraStats(CS_Source source, CS_UsbCameraStats* stats,
+                          CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+}
+
+void CS_SetUsbCameraLinger(CS_Source source, double seconds,
+                           CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+}
+
+double CS_GetUsbCameraLinger(CS_Source source, CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+  return 0;
+}
+
+void CS_SetUsbCameraStandbyFPS(CS_Source source, double fps,
+                               CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+}
+
+double CS_GetUsbCameraStandbyFPS(CS_Source source, CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+  return 0;
+}
+
+void CS_SetUsbCameraCacheFile(const char* path) {}
+
+char* CS_GetUsbCameraCacheFile(void) { return nullptr; }
+
+void CS_SetUsbCameraReactorThreads(int numThreads) {}
+
+int CS_GetUsbCameraReactorThreads(void) { return 0; }
+
+CS_Bool CS_PlanUsbCameraModes(const CS_Source* sources, int count,
+                              CS_VideoMode* modes, CS_Status* status) {
+  *status = CS_INVALID_HANDLE;
+  return false;
+}
+
 CS_UsbCameraInfo* CS_EnumerateUsbCameras(int* count, CS_Status* status) {
   *status = CS_INVALID_HANDLE;
   return nullptr;
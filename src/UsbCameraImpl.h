@@ -9,6 +9,7 @@
 #define CS_USBCAMERAIMPL_H_
 
 #include <atomic>
+#include <memory>
 #include <thread>
 #include <vector>
 
@@ -23,11 +24,16 @@
 
 #include "SourceImpl.h"
 #include "UsbCameraBuffer.h"
+#include "UsbCameraCache.h"
 #include "UsbCameraProperty.h"
 
 namespace cs {
 
+class UsbCameraReactor;
+
 class UsbCameraImpl : public SourceImpl {
+  friend class UsbCameraReactor;
+
  public:
   UsbCameraImpl(llvm::StringRef name, llvm::StringRef path);
   ~UsbCameraImpl() override;
@@ -38,6 +44,8 @@ class UsbCameraImpl : public SourceImpl {
   void SetProperty(int property, int value, CS_Status* status) override;
   void SetStringProperty(int property, llvm::StringRef value,
                          CS_Status* status) override;
+  void SetProperties(llvm::ArrayRef<int> properties, llvm::ArrayRef<int> values,
+                     CS_Status* status) override;
 
   // Standard common camera properties
   void SetBrightness(int brightness, CS_Status* status) override;
@@ -57,9 +65,52 @@ class UsbCameraImpl : public SourceImpl {
 
   void NumSinksChanged() override;
   void NumSinksEnabledChanged() override;
+  void ConversionHintsChanged() override;
 
   std::string GetPath() { return m_path; }
 
+  // Zero-copy mode: frames reference the driver's mmap buffers directly and
+  // each buffer is requeued when the last frame using it is released.
+  void SetZeroCopy(bool enabled) { m_zeroCopy = enabled; }
+  bool GetZeroCopy() const { return m_zeroCopy; }
+
+  // User pointer mode: the driver captures directly into pooled images, so
+  // no copy is ever made.  Falls back to mmap buffers if the driver does not
+  // support it.  Changing this reconnects to the camera.
+  bool SetUserBuffers(bool enabled, CS_Status* status);
+  bool GetUserBuffers() const { return m_userBuffers; }
+
+  // Number of driver buffers.  The requested count is also available as the
+  // "buffer_count" property; GetBufferCount() returns the number actually
+  // allocated, which can differ if the driver adjusts it or adaptive buffer
+  // counts are enabled.
+  void SetBufferCount(int count, CS_Status* status);
+  int GetBufferCount() const { return m_bufferCount; }
+
+  // Adaptive buffer count: grow above the requested count while the driver
+  // drops frames, and shrink back once capture keeps up.
+  void SetAdaptiveBuffers(bool enabled) { m_adaptiveBuffers = enabled; }
+  bool GetAdaptiveBuffers() const { return m_adaptiveBuffers; }
+
+  // Low latency mode: when several buffers are ready, publish only the
+  // newest and requeue the rest.  Skipped frames are counted.
+  void SetLowLatency(bool enabled) { m_lowLatency = enabled; }
+  bool GetLowLatency() const { return m_lowLatency; }
+  uint64_t GetFramesSkipped() const { return m_framesSkipped; }
+
+  // Capture statistics.  The fields are read individually, so a snapshot
+  // taken while frames arrive may be slightly inconsistent.
+  void GetStats(CS_UsbCameraStats* stats) const;
+
+  // Linger: how long (in seconds) to keep streaming after the last sink is
+  // disabled.  After that, streaming stops unless a standby rate is set, in
+  // which case frames keep being captured and published at that rate so a
+  // newly enabled sink gets a recent frame immediately.
+  void SetLinger(double seconds) { m_linger = seconds < 0 ? 0 : seconds; }
+  double GetLinger() const { return m_linger; }
+  void SetStandbyFPS(double fps) { m_standbyFPS = fps < 0 ? 0 : fps; }
+  double GetStandbyFPS() const { return m_standbyFPS; }
+
   // Messages passed to/from camera thread
   struct Message {
     enum Kind {
@@ -70,8 +121,12 @@ class UsbCameraImpl : public SourceImpl {
       kCmdSetFPS,
       kCmdSetProperty,
       kCmdSetPropertyStr,
+      kCmdSetProperties,
+      kCmdSetUserBuffers,
       kNumSinksChanged,         // no response
       kNumSinksEnabledChanged,  // no response
+      kConversionHintsChanged,  // no response
+      kCapabilitiesChecked,     // no response
       // Responses
       kOk,
       kError
@@ -82,6 +137,7 @@ class UsbCameraImpl : public SourceImpl {
     Kind kind;
     int data[4];
     std::string dataStr;
+    std::vector<std::pair<int, int>> dataProps;  // (property, value)
     std::thread::id from;
   };
 
@@ -100,21 +156,57 @@ class UsbCameraImpl : public SourceImpl {
   // Send a message to the camera thread with no response
   void Send(Message&& msg) const;
 
-  // The camera processing thread
+  // The camera processing thread (when not using the shared reactor)
   void CameraThreadMain();
 
-  // Functions used by CameraThreadMain()
+  // Steps of the camera thread, shared by CameraThreadMain() and the reactor.
+  // DeviceUpdate() does periodic work (reconnecting, starting and stopping
+  // streaming) and returns how long to wait for events, in milliseconds.
+  void DeviceInit(bool hotplugWatched);
+  int DeviceUpdate();
+  void DeviceHandleCommand();
+  void DeviceHandleFrame();
+  void DeviceHotplug(uint32_t mask);
+  void DeviceShutdown();
+
+  // Forwards an inotify event mask for the device path to the camera thread
+  void PostHotplug(uint32_t mask);
+
+  // Functions used by the camera thread
   void DeviceDisconnect();
   void DeviceConnect();
+  bool DeviceAllocBuffers();
+  bool DeviceFreeBuffers();
+  bool DeviceReallocBuffers(bool setMode);
   bool DeviceStreamOn();
   bool DeviceStreamOff();
   void DeviceProcessCommands();
   void DeviceSetMode();
-  void DeviceSetFPS();
+  bool DeviceSetFPS(bool warn = true);
   void DeviceCacheMode();
   void DeviceCacheProperty(std::unique_ptr<UsbCameraProperty> rawProp);
-  void DeviceCacheProperties();
-  void DeviceCacheVideoModes();
+  static void DeviceEnumerateControls(
+      int fd, std::vector<UsbCameraCache::Control>* controls);
+  static void DeviceEnumerateVideoModes(int fd, std::vector<VideoMode>* modes);
+  void DeviceCacheProperties(
+      const std::vector<UsbCameraCache::Control>& controls);
+  void DeviceCacheBufferCountProperty();
+  void DeviceCacheVideoModes(std::vector<VideoMode> modes);
+  void DeviceValidateCapabilities();
+  void DeviceApplyCheckedCapabilities();
+  void DeviceRequeueBuffers();
+#ifdef __linux__
+  bool DevicePutFrameZeroCopy(const struct v4l2_buffer& buf, Frame::Time time,
+                              Frame::Time dequeueTime);
+  bool DevicePutFrameUser(const struct v4l2_buffer& buf);
+  void DeviceTrackBuffers(const struct v4l2_buffer& buf);
+  void DeviceRecordBuffer(const struct v4l2_buffer& buf,
+                          Frame::Time dequeueTime);
+#endif
+  void DeviceRecordRequeueFailure();
+  bool DeviceCheckStandby();
+  void DeviceReconnect();
+  bool DeviceQueueUserBuffer(unsigned index);
 
   // Command helper functions
   CS_StatusValue DeviceProcessCommand(std::unique_lock<std::mutex>& lock,
@@ -123,6 +215,24 @@ class UsbCameraImpl : public SourceImpl {
                                   const Message& msg);
   CS_StatusValue DeviceCmdSetProperty(std::unique_lock<std::mutex>& lock,
                                       const Message& msg);
+  CS_StatusValue DeviceCmdSetProperties(std::unique_lock<std::mutex>& lock,
+                                        const Message& msg);
+  CS_StatusValue DeviceCmdSetBufferCount(std::unique_lock<std::mutex>& lock,
+                                         int property, int count);
+
+  // A checked property write.  Percentage properties are written through
+  // their raw pair, with both cached values updated.
+  struct PropertyWrite {
+    UsbCameraProperty* prop;  // property to set on the device
+    int property;             // its handle
+    int value;
+    int percentageProperty;  // paired property to update, or 0
+    int percentageValue;
+    bool bufferCount;  // buffer count setting rather than a control
+  };
+  CS_StatusValue DeviceCheckPropertyWrite(int property, int value,
+                                          bool setString,
+                                          PropertyWrite* write);
 
   // Property helper functions
   int RawToPercentage(const UsbCameraProperty& rawProp, int rawValue);
@@ -134,6 +244,23 @@ class UsbCameraImpl : public SourceImpl {
   // Variables only used within camera thread
   //
   bool m_streaming;
+  bool m_wasStreaming = false;  // restart streaming on reconnect
+  bool m_hotplugWatched = false;
+  bool m_notified = false;  // device may have (re)appeared
+  bool m_lost = false;  // device lost; counted as a reconnect once reopened
+  unsigned m_disconnectCount = 0;  // lets the reactor detect closed fds
+  uint64_t m_idleSince = 0;  // when the last sink was disabled (lingering)
+  bool m_standby = false;    // streaming at the standby rate
+  uint64_t m_lastStandbyFrame = 0;
+  uint64_t m_modeSwitchStart = 0;  // for reporting time to first frame
+  uint64_t m_startTime = 0;        // creation time, until the first frame
+  std::string m_capabilityKey;     // capability cache key
+  bool m_validateCapabilities = false;
+  // Checks the cache against the device on its own fd; the result is left
+  // in m_checkedCapabilities (protected by m_mutex) for the camera thread
+  std::thread m_validateThread;
+  std::atomic_bool m_capabilitiesChecked{false};
+  UsbCameraCache::Entry m_checkedCapabilities;
   bool m_modeSetPixelFormat{false};
   bool m_modeSetResolution{false};
   bool m_modeSetFPS{false};
@@ -141,15 +268,55 @@ class UsbCameraImpl : public SourceImpl {
   unsigned m_capabilities = 0;
 #endif
   // Number of buffers to ask OS for
-  static constexpr int kNumBuffers = 4;
+  static constexpr int kDefaultNumBuffers = 4;
+  static constexpr int kMinNumBuffers = 2;
+  static constexpr int kMaxNumBuffers = 32;  // VIDEO_MAX_FRAME
+  int m_bufferCountSetting = kDefaultNumBuffers;  // from property
+  int m_bufferCountTarget = kDefaultNumBuffers;   // setting plus adaptation
+  bool m_bufferCountChanged = false;  // target changed; reconnect needed
+  // Adaptive buffer count statistics (current window)
+  uint64_t m_adaptWindowStart = 0;
+  int m_adaptFrames = 0;
+  int m_adaptDrops = 0;
+  int m_adaptStale = 0;  // frames dequeued more than 2 intervals late
+  int m_adaptCalmWindows = 0;
+  bool m_adaptHaveSequence = false;
+  uint32_t m_adaptLastSequence = 0;
+  // Capture statistics state (reset when streaming starts)
+  bool m_statsHaveSequence = false;
+  uint32_t m_statsLastSequence = 0;
+  uint64_t m_statsLastCapture = 0;
+  int m_statsUnreported = 0;  // lost frames not yet notified
+  uint64_t m_statsLastReport = 0;
+  // Zero-copy frames fall back to copying rather than leave fewer than this
+  // many buffers queued to the driver.
+  static constexpr int kMinQueuedBuffers = 2;
 #ifdef __linux__
-  std::array<UsbCameraBuffer, kNumBuffers> m_buffers;
+  // Buffer bookkeeping shared with zero-copy frames, which may outlive both
+  // the device connection and this object.  Frames hold a reference to their
+  // buffer's mapping, so it is only unmapped when the last one is released.
+  struct BufferState {
+    std::mutex mutex;
+    unsigned generation = 0;  // incremented on disconnect
+    std::vector<bool> outstanding;  // held by frames
+    std::vector<unsigned> released;  // awaiting requeue by camera thread
+    int wakeFd = -1;                 // command eventfd, -1 when destroyed
+  };
+  std::shared_ptr<BufferState> m_bufferState;
+  std::vector<std::shared_ptr<UsbCameraBuffer>> m_buffers;
+  // Buffer memory type of the current connection
+  unsigned m_memory = V4L2_MEMORY_MMAP;
 #endif
+  // Pool images queued to the driver (user pointer mode only)
+  std::vector<std::unique_ptr<Image>> m_userImages;
+  std::size_t m_userBufferSize = 0;
 
   //
   // Path never changes, so not protected by mutex.
   //
   std::string m_path;
+  std::string m_pathDir;   // directory part of m_path
+  std::string m_pathBase;  // file part of m_path
 
 #ifdef __linux__
   std::atomic_int m_fd;
@@ -157,7 +324,34 @@ class UsbCameraImpl : public SourceImpl {
 #endif
 
   std::atomic_bool m_active;  // set to false to terminate thread
+  std::atomic_bool m_zeroCopy{false};
+  std::atomic_bool m_userBuffers{false};
+  std::atomic_bool m_adaptiveBuffers{false};
+  std::atomic_bool m_lowLatency{false};
+  std::atomic<uint64_t> m_framesSkipped{0};
+  // Capture statistics.  Only the camera thread writes these, so they are
+  // updated without read-modify-write operations.
+  struct Stats {
+    std::atomic<uint64_t> framesCaptured{0};
+    std::atomic<uint64_t> framesDropped{0};
+    std::atomic<uint64_t> errorBuffers{0};
+    std::atomic<uint64_t> requeueFailures{0};
+    std::atomic<uint64_t> reconnects{0};
+    std::atomic<uint64_t> intervalCount{0};
+    std::atomic<uint64_t> intervalTotal{0};
+    std::atomic<uint64_t> intervalMin{0};
+    std::atomic<uint64_t> intervalMax{0};
+    std::atomic<uint64_t> latenessCount{0};
+    std::atomic<uint64_t> latenessTotal{0};
+    std::atomic<uint64_t> latenessMax{0};
+  };
+  Stats m_stats;
+  std::atomic<double> m_linger{0};
+  std::atomic<double> m_standbyFPS{0};
+  std::atomic_int m_bufferCount{0};
   std::thread m_cameraThread;
+  bool m_reactor{false};  // serviced by UsbCameraReactor instead
+  std::atomic<uint32_t> m_hotplugEvents{0};
 
   // Quirks
   bool m_hd3000{false};  // Microsoft LifeCam HD-3000
@@ -172,6 +366,10 @@ class UsbCameraImpl : public SourceImpl {
   mutable std::condition_variable m_responseCv;
 };
 
+// Returns the description of the camera at path, or an empty string if it
+// can't be opened.  May open the device and scan usb.ids.
+std::string GetUsbCameraDescription(const char* path);
+
 }  // namespace cs
 
 #endif  // CS_USBCAMERAIMPL_H_
@@ -7,6 +7,8 @@
 
 #include "UsbCameraProperty.h"
 
+#include <algorithm>
+
 #include "llvm/SmallString.h"
 #include "llvm/STLExtras.h"
 
@@ -317,5 +319,63 @@ bool UsbCameraProperty::DeviceSet(std::unique_lock<std::mutex>& lock, int fd,
   return rv >= 0;
 }
 
+void UsbCameraProperty::DeviceSetMultiple(
+    std::unique_lock<std::mutex>& lock, int fd,
+    llvm::ArrayRef<const UsbCameraProperty*> props, llvm::ArrayRef<int> values,
+    llvm::SmallVectorImpl<bool>& ok) {
+  ok.assign(props.size(), true);
+  if (fd < 0) return;
+
+  // Copy what's needed while locked
+  llvm::SmallVector<unsigned, 16> ids;
+  llvm::SmallVector<int, 16> types;
+  for (auto prop : props) {
+    ids.push_back(prop->id);
+    types.push_back(prop->type);
+  }
+  lock.unlock();
+
+  // Group by control class, keeping the order within each class as some
+  // controls (e.g. auto exposure) must be set before others
+  llvm::SmallVector<unsigned, 4> classes;
+  for (std::size_t i = 0; i < ids.size(); ++i) {
+    unsigned ctrl_class = V4L2_CTRL_ID2CLASS(ids[i]);
+    if (std::find(classes.begin(), classes.end(), ctrl_class) ==
+        classes.end())
+      classes.push_back(ctrl_class);
+  }
+
+  for (auto ctrl_class : classes) {
+    llvm::SmallVector<std::size_t, 16> indices;
+    llvm::SmallVector<struct v4l2_ext_control, 16> ctrlArray;
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+      if (V4L2_CTRL_ID2CLASS(ids[i]) != ctrl_class) continue;
+      struct v4l2_ext_control ctrl;
+      std::memset(&ctrl, 0, sizeof(ctrl));
+      ctrl.id = ids[i];
+      if (types[i] == V4L2_CTRL_TYPE_INTEGER64)
+        ctrl.value64 = values[i];
+      else
+        ctrl.value = values[i];
+      indices.push_back(i);
+      ctrlArray.push_back(ctrl);
+    }
+
+    // Old-style private controls can't be set as extended controls
+    if (ctrl_class != V4L2_CID_PRIVATE_BASE) {
+      struct v4l2_ext_controls ctrls;
+      std::memset(&ctrls, 0, sizeof(ctrls));
+      ctrls.ctrl_class = ctrl_class;
+      ctrls.count = ctrlArray.size();
+      ctrls.controls = ctrlArray.data();
+      if (TryIoctl(fd, VIDIOC_S_EXT_CTRLS, &ctrls) == 0) continue;
+    }
+
+    for (auto i : indices)
+      ok[i] = SetIntCtrlIoctl(fd, ids[i], types[i], values[i]) >= 0;
+  }
+
+  lock.lock();
+}
 
 #endif  // __linux__
@@ -15,6 +15,9 @@
 #include <linux/videodev2.h>
 #endif
 
+#include "llvm/ArrayRef.h"
+#include "llvm/SmallVector.h"
+
 #include "PropertyImpl.h"
 
 namespace cs {
@@ -52,6 +55,14 @@ class UsbCameraProperty : public PropertyImpl {
   bool DeviceSet(std::unique_lock<std::mutex>& lock, int fd) const;
   bool DeviceSet(std::unique_lock<std::mutex>& lock, int fd, int newValue,
                  llvm::StringRef newValueStr) const;
+
+  // Sets several integer properties using one VIDIOC_S_EXT_CTRLS call per
+  // control class, falling back to individual sets if the driver rejects
+  // the batch.  ok is filled with the per-property result.
+  static void DeviceSetMultiple(std::unique_lock<std::mutex>& lock, int fd,
+                                llvm::ArrayRef<const UsbCameraProperty*> props,
+                                llvm::ArrayRef<int> values,
+                                llvm::SmallVectorImpl<bool>& ok);
 #endif
 
   // If this is a percentage (rather than raw) property
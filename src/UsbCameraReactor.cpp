@@ -0,0 +1,415 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifdef __linux__
+
+#include "UsbCameraReactor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "llvm/StringRef.h"
+
+#include "Log.h"
+#include "UsbCameraImpl.h"
+
+using namespace cs;
+
+ATOMIC_STATIC_INIT(UsbCameraReactor)
+
+bool UsbCameraReactor::s_destroyed = false;
+
+// Maximum number of reactor threads
+static constexpr int kMaxThreads = 16;
+
+// Maximum number of events handled per epoll_wait()
+static constexpr int kMaxEvents = 32;
+
+class UsbCameraReactor::Thread {
+ public:
+  Thread(UsbCameraReactor& reactor, int notifyFd);
+  ~Thread();
+
+  bool IsValid() const { return m_epollFd >= 0 && m_wakeFd >= 0; }
+
+  void Add(UsbCameraImpl* camera, bool hotplugWatched);
+  void Remove(UsbCameraImpl* camera);
+
+ private:
+  void Main();
+  void Wake() { eventfd_write(m_wakeFd, 1); }
+
+  enum Kind { kWake, kNotify, kCommand, kDevice };
+  struct Entry;
+  struct Tag {
+    Kind kind;
+    Entry* entry;
+  };
+  struct Entry {
+    UsbCameraImpl* camera;
+    bool hotplugWatched;
+    bool started{false};
+    bool removing{false};
+    Tag commandTag;
+    Tag deviceTag;
+    int commandFd{-1};
+    // Device fd registered with epoll (only while streaming), and the
+    // camera's disconnect count at the time; if the camera has disconnected
+    // since, the fd was closed and epoll already forgot it.
+    int deviceFd{-1};
+    unsigned deviceDisconnects{0};
+    // DeviceUpdate() only runs when the camera had a command or its device
+    // state changed, or when the timeout it last returned expires, so frame
+    // events for one camera don't cost every camera an update.
+    bool updateNeeded{true};
+    std::chrono::steady_clock::time_point nextUpdate;
+  };
+
+  void UpdateDeviceFd(Entry& entry);
+
+  UsbCameraReactor& m_reactor;
+  int m_epollFd;
+  int m_wakeFd;
+  Tag m_wakeTag{kWake, nullptr};
+  Tag m_notifyTag{kNotify, nullptr};
+
+  std::mutex m_mutex;
+  std::condition_variable m_removedCv;
+  std::vector<std::unique_ptr<Entry>> m_entries;
+
+  std::atomic_bool m_active{true};
+  std::thread m_thread;
+};
+
+UsbCameraReactor::Thread::Thread(UsbCameraReactor& reactor, int notifyFd)
+    : m_reactor(reactor),
+      m_epollFd{epoll_create1(EPOLL_CLOEXEC)},
+      m_wakeFd{eventfd(0, EFD_CLOEXEC)} {
+  if (!IsValid()) return;
+
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = &m_wakeTag;
+  epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &ev);
+  if (notifyFd >= 0) {
+    ev.data.ptr = &m_notifyTag;
+    epoll_ctl(m_epollFd, EPOLL_CTL_ADD, notifyFd, &ev);
+  }
+
+  m_thread = std::thread(&Thread::Main, this);
+}
+
+UsbCameraReactor::Thread::~Thread() {
+  m_active = false;
+  if (m_wakeFd >= 0) Wake();
+  if (m_thread.joinable()) m_thread.join();
+  if (m_epollFd >= 0) close(m_epollFd);
+  if (m_wakeFd >= 0) close(m_wakeFd);
+}
+
+void UsbCameraReactor::Thread::Add(UsbCameraImpl* camera,
+                                   bool hotplugWatched) {
+  std::unique_ptr<Entry> entry{new Entry};
+  entry->camera = camera;
+  entry->hotplugWatched = hotplugWatched;
+  entry->commandTag = Tag{kCommand, entry.get()};
+  entry->deviceTag = Tag{kDevice, entry.get()};
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.emplace_back(std::move(entry));
+  }
+  Wake();
+}
+
+void UsbCameraReactor::Thread::Remove(UsbCameraImpl* camera) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  auto find = [&] {
+    return std::find_if(m_entries.begin(), m_entries.end(),
+                        [=](const std::unique_ptr<Entry>& entry) {
+                          return entry->camera == camera;
+                        });
+  };
+  auto it = find();
+  if (it == m_entries.end()) return;
+  (*it)->removing = true;
+  Wake();
+  m_removedCv.wait(lock,
+                   [&] { return !m_active || find() == m_entries.end(); });
+}
+
+void UsbCameraReactor::Thread::UpdateDeviceFd(Entry& entry) {
+  auto camera = entry.camera;
+  int fd = camera->m_streaming ? camera->m_fd.load() : -1;
+  if (fd == entry.deviceFd &&
+      camera->m_disconnectCount == entry.deviceDisconnects)
+    return;
+
+  // Unregister the old fd if it is still open
+  if (entry.deviceFd >= 0 &&
+      camera->m_disconnectCount == entry.deviceDisconnects)
+    epoll_ctl(m_epollFd, EPOLL_CTL_DEL, entry.deviceFd, nullptr);
+
+  entry.deviceFd = fd;
+  entry.deviceDisconnects = camera->m_disconnectCount;
+  if (fd < 0) return;
+
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = &entry.deviceTag;
+  if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+    ERROR("UsbCameraReactor: could not add device fd: " << strerror(errno));
+    entry.deviceFd = -1;
+  }
+}
+
+void UsbCameraReactor::Thread::Main() {
+  std::vector<Entry*> current;
+  std::vector<Entry*> removing;
+  struct epoll_event events[kMaxEvents];
+
+  while (m_active) {
+    current.clear();
+    removing.clear();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (auto& entry : m_entries)
+        (entry->removing ? removing : current).push_back(entry.get());
+    }
+
+    // Shut down removed cameras.  Entries are only erased by this thread, so
+    // the pointers stay valid outside the lock.
+    if (!removing.empty()) {
+      for (auto entry : removing) {
+        if (entry->commandFd >= 0)
+          epoll_ctl(m_epollFd, EPOLL_CTL_DEL, entry->commandFd, nullptr);
+        if (entry->deviceFd >= 0 && entry->camera->m_disconnectCount ==
+                                         entry->deviceDisconnects)
+          epoll_ctl(m_epollFd, EPOLL_CTL_DEL, entry->deviceFd, nullptr);
+        if (entry->started) entry->camera->DeviceShutdown();
+      }
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.erase(
+            std::remove_if(m_entries.begin(), m_entries.end(),
+                           [&](const std::unique_ptr<Entry>& entry) {
+                             return std::find(removing.begin(), removing.end(),
+                                              entry.get()) != removing.end();
+                           }),
+            m_entries.end());
+      }
+      m_removedCv.notify_all();
+    }
+
+    // Periodic work for each camera that needs it.  This may connect,
+    // disconnect, or start or stop streaming, so device fd registrations are
+    // updated afterwards.
+    auto now = std::chrono::steady_clock::now();
+    int timeout = -1;
+    for (auto entry : current) {
+      auto camera = entry->camera;
+      if (!entry->started) {
+        entry->started = true;
+        camera->DeviceInit(entry->hotplugWatched);
+        entry->commandFd = camera->m_command_fd.load();
+        if (entry->commandFd >= 0) {
+          struct epoll_event ev;
+          ev.events = EPOLLIN;
+          ev.data.ptr = &entry->commandTag;
+          epoll_ctl(m_epollFd, EPOLL_CTL_ADD, entry->commandFd, &ev);
+        }
+      }
+      if (entry->updateNeeded || now >= entry->nextUpdate) {
+        entry->updateNeeded = false;
+        entry->nextUpdate =
+            now + std::chrono::milliseconds(camera->DeviceUpdate());
+        UpdateDeviceFd(*entry);
+      }
+      auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+          entry->nextUpdate - now);
+      int camTimeout = wait.count() < 0 ? 0 : wait.count() + 1;
+      if (timeout < 0 || camTimeout < timeout) timeout = camTimeout;
+    }
+
+    int n = epoll_wait(m_epollFd, events, kMaxEvents, timeout);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      ERROR("UsbCameraReactor: epoll_wait(): " << strerror(errno));
+      break;
+    }
+    if (!m_active) break;
+
+    for (int i = 0; i < n; ++i) {
+      auto tag = static_cast<Tag*>(events[i].data.ptr);
+      switch (tag->kind) {
+        case kWake: {
+          eventfd_t val;
+          eventfd_read(m_wakeFd, &val);
+          break;
+        }
+        case kNotify:
+          m_reactor.HandleNotify();
+          break;
+        case kCommand:
+          tag->entry->camera->DeviceHandleCommand();
+          tag->entry->updateNeeded = true;
+          break;
+        case kDevice: {
+          // An earlier event may have disconnected or stopped the camera
+          auto entry = tag->entry;
+          auto camera = entry->camera;
+          if (camera->m_streaming && camera->m_fd == entry->deviceFd &&
+              camera->m_disconnectCount == entry->deviceDisconnects) {
+            camera->DeviceHandleFrame();
+            // Disconnects and adaptive buffer count changes are handled by
+            // DeviceUpdate()
+            if (camera->m_disconnectCount != entry->deviceDisconnects ||
+                camera->m_bufferCountChanged)
+              entry->updateNeeded = true;
+          }
+          break;
+        }
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_active = false;
+  m_removedCv.notify_all();
+}
+
+UsbCameraReactor::UsbCameraReactor() { s_destroyed = false; }
+
+UsbCameraReactor::~UsbCameraReactor() {
+  s_destroyed = true;
+  // Shut down cameras still being serviced (at exit, Sources may destroy
+  // them later) while the threads are still running
+  for (;;) {
+    UsbCameraImpl* camera;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_cameras.empty()) break;
+      camera = m_cameras.back().camera;
+    }
+    Remove(camera);
+  }
+  m_threads.clear();
+  if (m_notifyFd >= 0) close(m_notifyFd);
+}
+
+void UsbCameraReactor::SetNumThreads(int numThreads) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_numThreads = std::max(0, std::min(numThreads, kMaxThreads));
+}
+
+int UsbCameraReactor::GetNumThreads() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_numThreads;
+}
+
+bool UsbCameraReactor::Add(UsbCameraImpl* camera) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_numThreads <= 0) return false;
+
+  // A single inotify fd, serviced by the first thread, watches the device
+  // directories of all cameras
+  if (m_threads.empty() && m_notifyFd < 0)
+    m_notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  // Start threads up to the limit, then use the least loaded one
+  if (static_cast<int>(m_threads.size()) < m_numThreads) {
+    std::unique_ptr<Thread> thread{
+        new Thread{*this, m_threads.empty() ? m_notifyFd : -1}};
+    if (thread->IsValid()) m_threads.emplace_back(std::move(thread));
+  }
+  Thread* thread = nullptr;
+  std::size_t least = 0;
+  std::size_t numThreads =
+      std::min(m_threads.size(), static_cast<std::size_t>(m_numThreads));
+  for (std::size_t i = 0; i < numThreads; ++i) {
+    auto count = std::count_if(
+        m_cameras.begin(), m_cameras.end(),
+        [&](const Camera& c) { return c.thread == m_threads[i].get(); });
+    if (!thread || static_cast<std::size_t>(count) < least) {
+      thread = m_threads[i].get();
+      least = count;
+    }
+  }
+  if (!thread) return false;
+
+  int wd = WatchDir(camera->m_pathDir);
+  m_cameras.emplace_back(Camera{camera, thread, wd});
+  thread->Add(camera, wd >= 0);
+  return true;
+}
+
+void UsbCameraReactor::Remove(UsbCameraImpl* camera) {
+  Thread* thread;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = std::find_if(m_cameras.begin(), m_cameras.end(),
+                           [=](const Camera& c) { return c.camera == camera; });
+    if (it == m_cameras.end()) return;
+    thread = it->thread;
+    if (it->wd >= 0) UnwatchDir(it->wd);
+    m_cameras.erase(it);
+  }
+  // Not under m_mutex; the first thread takes it to dispatch hotplug events
+  thread->Remove(camera);
+}
+
+int UsbCameraReactor::WatchDir(const std::string& dir) {
+  if (m_notifyFd < 0) return -1;
+  for (auto& watch : m_watches) {
+    if (watch.dir == dir) {
+      ++watch.refCount;
+      return watch.wd;
+    }
+  }
+  int wd = inotify_add_watch(m_notifyFd, dir.c_str(), IN_CREATE | IN_DELETE);
+  if (wd < 0) return -1;
+  m_watches.emplace_back(Watch{wd, dir, 1});
+  return wd;
+}
+
+void UsbCameraReactor::UnwatchDir(int wd) {
+  auto it = std::find_if(m_watches.begin(), m_watches.end(),
+                         [=](const Watch& w) { return w.wd == wd; });
+  if (it == m_watches.end() || --it->refCount > 0) return;
+  inotify_rm_watch(m_notifyFd, wd);
+  m_watches.erase(it);
+}
+
+void UsbCameraReactor::HandleNotify() {
+  alignas(struct inotify_event) char buf[4096];
+  for (;;) {
+    ssize_t len = read(m_notifyFd, buf, sizeof(buf));
+    if (len <= 0) break;  // drained (EAGAIN) or error
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (char* p = buf; p < buf + len;) {
+      auto event = reinterpret_cast<struct inotify_event*>(p);
+      p += sizeof(struct inotify_event) + event->len;
+      if (event->len == 0) continue;
+      llvm::StringRef name{event->name};
+      DEBUG4("UsbCameraReactor: got event on '" << name << "' mask "
+                                                << event->mask);
+      for (auto& c : m_cameras) {
+        if (c.wd == event->wd && c.camera->m_pathBase == name)
+          c.camera->PostHotplug(event->mask);
+      }
+    }
+  }
+}
+
+#endif  // __linux__
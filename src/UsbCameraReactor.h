@@ -0,0 +1,90 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef CS_USBCAMERAREACTOR_H_
+#define CS_USBCAMERAREACTOR_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "support/atomic_static.h"
+
+namespace cs {
+
+class UsbCameraImpl;
+
+// Optional shared capture reactor.  Instead of one thread per USB camera,
+// a few threads each use epoll to service many cameras' device and command
+// fds, and a single inotify fd watches the device directories for hotplug
+// events.  Disabled (0 threads) by default.
+class UsbCameraReactor {
+ public:
+  static UsbCameraReactor& GetInstance() {
+    ATOMIC_STATIC(UsbCameraReactor, instance);
+    return instance;
+  }
+  ~UsbCameraReactor();
+
+  // The instance is created lazily, so it may be destroyed before the
+  // cameras are at exit (it shuts them down first); it must not be used
+  // once this returns true.
+  static bool destroyed() { return s_destroyed; }
+
+  // Sets the number of reactor threads.  0 disables the reactor.  Only
+  // affects cameras started afterwards.
+  void SetNumThreads(int numThreads);
+  int GetNumThreads() const;
+
+  // Starts servicing camera.  Returns false if the reactor is disabled, in
+  // which case the camera should run its own thread.
+  bool Add(UsbCameraImpl* camera);
+
+  // Shuts down camera's device and stops servicing it.  Blocks until the
+  // reactor thread no longer references camera.
+  void Remove(UsbCameraImpl* camera);
+
+ private:
+  UsbCameraReactor();
+
+  class Thread;
+
+  // Hotplug (inotify) handling; called from the first thread
+  int WatchDir(const std::string& dir);
+  void UnwatchDir(int wd);
+  void HandleNotify();
+
+  struct Watch {
+    int wd;
+    std::string dir;
+    int refCount;
+  };
+
+  struct Camera {
+    UsbCameraImpl* camera;
+    Thread* thread;
+    int wd;  // inotify watch descriptor of the camera's directory
+  };
+
+  mutable std::mutex m_mutex;
+  int m_numThreads{0};
+  std::vector<std::unique_ptr<Thread>> m_threads;
+  std::vector<Camera> m_cameras;
+  std::vector<Watch> m_watches;
+  int m_notifyFd{-1};
+
+  ATOMIC_STATIC_DECL(UsbCameraReactor)
+  static bool s_destroyed;
+};
+
+}  // namespace cs
+
+#endif  // CS_USBCAMERAREACTOR_H_
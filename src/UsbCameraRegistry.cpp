@@ -0,0 +1,255 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "UsbCameraRegistry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "llvm/SmallString.h"
+
+#include "Log.h"
+#include "Notifier.h"
+#ifdef __linux__
+#include "UsbCameraImpl.h"
+#endif
+
+using namespace cs;
+
+ATOMIC_STATIC_INIT(UsbCameraRegistry)
+
+class UsbCameraRegistry::Thread : public wpi::SafeThread {
+ public:
+  // The wake fd is created before the thread starts and lives as long as
+  // the thread object, so Stop() can always signal it
+  explicit Thread(UsbCameraRegistry& registry) : m_registry(registry) {
+#ifdef __linux__
+    m_command_fd = eventfd(0, 0);
+#endif
+  }
+#ifdef __linux__
+  ~Thread() {
+    if (m_command_fd >= 0) close(m_command_fd);
+  }
+#endif
+
+  void Main();
+
+  UsbCameraRegistry& m_registry;
+#ifdef __linux__
+  int m_command_fd = -1;
+#endif
+};
+
+static bool CompareDev(const UsbCameraInfo& a, const UsbCameraInfo& b) {
+  return a.dev < b.dev;
+}
+
+UsbCameraRegistry::~UsbCameraRegistry() { Stop(); }
+
+void UsbCameraRegistry::Start() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto thr = m_owner.GetThread();
+  if (!thr) m_owner.Start(new Thread(*this));
+}
+
+void UsbCameraRegistry::Stop() {
+  // Wake up thread
+  if (auto thr = m_owner.GetThread()) {
+    thr->m_active = false;
+#ifdef __linux__
+    if (thr->m_command_fd >= 0) eventfd_write(thr->m_command_fd, 1);
+#endif
+  }
+  m_owner.Stop();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_scanned = false;
+}
+
+std::vector<UsbCameraInfo> UsbCameraRegistry::GetCameras() {
+  Start();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_scannedCond.wait(lock, [&] { return m_scanned; });
+  if (m_watching) return m_cameras;
+
+  // Without hotplug events the list can't be kept current
+  lock.unlock();
+  return Scan();
+}
+
+std::vector<UsbCameraInfo> UsbCameraRegistry::Probe(
+    llvm::ArrayRef<std::string> names) {
+  std::vector<UsbCameraInfo> cameras;
+#ifdef __linux__
+  // Opening a device can take a while, so describe them all in parallel
+  std::vector<std::future<std::string>> descriptions;
+  for (const auto& name : names) {
+    descriptions.emplace_back(std::async(std::launch::async, [=] {
+      return GetUsbCameraDescription(("/dev/" + name).c_str());
+    }));
+  }
+
+  for (std::size_t i = 0; i < names.size(); ++i) {
+    UsbCameraInfo info;
+    info.dev = -1;
+    llvm::StringRef{names[i]}.substr(5).getAsInteger(10, info.dev);
+    info.path = "/dev/" + names[i];
+    info.name = descriptions[i].get();
+    if (info.name.empty()) continue;
+    cameras.emplace_back(std::move(info));
+  }
+#endif
+  return cameras;
+}
+
+std::vector<UsbCameraInfo> UsbCameraRegistry::Scan() {
+  std::vector<std::string> names;
+#ifdef __linux__
+  if (DIR* dp = opendir("/dev")) {
+    while (struct dirent* ep = readdir(dp)) {
+      llvm::StringRef fname{ep->d_name};
+      if (fname.startswith("video")) names.emplace_back(fname);
+    }
+    closedir(dp);
+  } else {
+    ERROR("Could not open /dev");
+  }
+#endif
+  auto cameras = Probe(names);
+  std::sort(cameras.begin(), cameras.end(), CompareDev);
+  return cameras;
+}
+
+void UsbCameraRegistry::SetCameras(std::vector<UsbCameraInfo> cameras,
+                                   bool watching) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cameras = std::move(cameras);
+    m_watching = watching;
+    m_scanned = true;
+  }
+  m_scannedCond.notify_all();
+}
+
+bool UsbCameraRegistry::Update(llvm::ArrayRef<std::string> removed,
+                               std::vector<UsbCameraInfo> added) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto oldSize = m_cameras.size();
+  m_cameras.erase(
+      std::remove_if(m_cameras.begin(), m_cameras.end(),
+                     [&](const UsbCameraInfo& info) {
+                       return std::any_of(
+                           removed.begin(), removed.end(),
+                           [&](const std::string& name) {
+                             return info.path == "/dev/" + name;
+                           });
+                     }),
+      m_cameras.end());
+  bool changed = m_cameras.size() != oldSize || !added.empty();
+
+  for (auto& info : added) {
+    auto it = std::find_if(
+        m_cameras.begin(), m_cameras.end(),
+        [&](const UsbCameraInfo& oth) { return oth.path == info.path; });
+    if (it != m_cameras.end())
+      *it = std::move(info);
+    else
+      m_cameras.emplace_back(std::move(info));
+  }
+  std::sort(m_cameras.begin(), m_cameras.end(), CompareDev);
+  return changed;
+}
+
+bool UsbCameraRegistry::Contains(llvm::StringRef name) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return std::any_of(m_cameras.begin(), m_cameras.end(),
+                     [&](const UsbCameraInfo& info) {
+                       return llvm::StringRef{info.path}.substr(5) == name;
+                     });
+}
+
+void UsbCameraRegistry::Thread::Main() {
+#ifdef __linux__
+  // Watch /dev before scanning so no device is missed.  Attribute changes
+  // matter as udev may only make a new device accessible after creating it.
+  int notify_fd = inotify_init();
+  if (notify_fd >= 0 &&
+      inotify_add_watch(notify_fd, "/dev", IN_CREATE | IN_DELETE | IN_ATTRIB) <
+          0) {
+    close(notify_fd);
+    notify_fd = -1;
+  }
+  bool watching = notify_fd >= 0 && m_command_fd >= 0;
+  if (!watching)
+    WARNING("UsbCameraRegistry: cannot watch /dev; enumerating on each call");
+
+  m_registry.SetCameras(Scan(), watching);
+
+  alignas(struct inotify_event) char buf[4096];
+  while (watching && m_active) {
+    struct pollfd fds[2];
+    fds[0].fd = notify_fd;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = m_command_fd;
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) continue;
+      ERROR("UsbCameraRegistry: poll(): " << std::strerror(errno));
+      break;
+    }
+
+    // Double-check to see if we're shutting down
+    if (!m_active) break;
+
+    if ((fds[0].revents & POLLIN) == 0) continue;
+    ssize_t len = read(notify_fd, buf, sizeof(buf));
+    if (len <= 0) continue;
+
+    // Collect the video devices that went away or (re)appeared
+    std::vector<std::string> removed;
+    std::vector<std::string> candidates;
+    for (char* p = buf; p < buf + len;) {
+      auto event = reinterpret_cast<struct inotify_event*>(p);
+      p += sizeof(struct inotify_event) + event->len;
+      if (event->len == 0) continue;
+      llvm::StringRef name{event->name};
+      if (!name.startswith("video")) continue;
+
+      auto candidate = std::find(candidates.begin(), candidates.end(), name);
+      if (event->mask & IN_DELETE) {
+        if (candidate != candidates.end()) candidates.erase(candidate);
+        removed.emplace_back(name);
+      } else if (candidate == candidates.end() &&
+                 ((event->mask & IN_CREATE) != 0 ||
+                  !m_registry.Contains(name))) {
+        candidates.emplace_back(name);
+      }
+    }
+    if (removed.empty() && candidates.empty()) continue;
+
+    if (m_registry.Update(removed, Probe(candidates)))
+      Notifier::GetInstance().NotifyUsbCamerasChanged();
+  }
+
+  if (notify_fd >= 0) close(notify_fd);
+#else
+  m_registry.SetCameras(std::vector<UsbCameraInfo>{}, false);
+#endif
+}
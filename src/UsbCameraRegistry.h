@@ -0,0 +1,71 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#ifndef CS_USBCAMERAREGISTRY_H_
+#define CS_USBCAMERAREGISTRY_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "llvm/ArrayRef.h"
+#include "support/atomic_static.h"
+#include "support/SafeThread.h"
+
+#include "cscore_cpp.h"
+
+namespace cs {
+
+// Process-wide list of USB cameras, kept current by a hotplug watcher
+// thread so enumeration doesn't have to open every device.  Devices are
+// only opened (in parallel) when they appear.  Changes are reported with
+// CS_USB_CAMERAS_CHANGED events.
+class UsbCameraRegistry {
+ public:
+  static UsbCameraRegistry& GetInstance() {
+    ATOMIC_STATIC(UsbCameraRegistry, instance);
+    return instance;
+  }
+  ~UsbCameraRegistry();
+
+  void Start();
+  void Stop();
+
+  // Returns the current cameras sorted by device number.  Starts the
+  // watcher if needed and waits for its initial scan.
+  std::vector<UsbCameraInfo> GetCameras();
+
+ private:
+  UsbCameraRegistry() = default;
+
+  class Thread;
+
+  // Opens and describes the named /dev entries in parallel
+  static std::vector<UsbCameraInfo> Probe(llvm::ArrayRef<std::string> names);
+  static std::vector<UsbCameraInfo> Scan();
+
+  // Called by the watcher thread
+  void SetCameras(std::vector<UsbCameraInfo> cameras, bool watching);
+  bool Update(llvm::ArrayRef<std::string> removed,
+              std::vector<UsbCameraInfo> added);
+  bool Contains(llvm::StringRef name);
+
+  wpi::SafeThreadOwner<Thread> m_owner;
+
+  std::mutex m_mutex;
+  std::condition_variable m_scannedCond;
+  bool m_scanned{false};
+  bool m_watching{false};  // false if hotplug events are unavailable
+  std::vector<UsbCameraInfo> m_cameras;
+
+  ATOMIC_STATIC_DECL(UsbCameraRegistry)
+};
+
+}  // namespace cs
+
+#endif  // CS_USBCAMERAREGISTRY_H_
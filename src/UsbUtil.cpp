@@ -7,77 +7,150 @@
 
 #include "UsbUtil.h"
 
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
 #include <fcntl.h>
 #ifdef __linux__
 #include <libgen.h>
 #include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
-#include "llvm/Format.h"
 #include "llvm/SmallString.h"
 #include "llvm/raw_ostream.h"
-#include "support/raw_istream.h"
+#include "support/atomic_static.h"
 
-#include "HttpUtil.h"
 #include "Log.h"
 
 namespace cs {
 
 #ifdef __linux__
 
-static llvm::StringRef GetUsbNameFromFile(int vendor, int product,
-                                          llvm::SmallVectorImpl<char>& buf) {
-  int fd = open("/var/lib/usbutils/usb.ids", O_RDONLY);
-  if (fd < 0) return llvm::StringRef{};
+static constexpr const char* kUsbIdsPath = "/var/lib/usbutils/usb.ids";
 
-  llvm::raw_svector_ostream os{buf};
-  wpi::raw_fd_istream is{fd, true};
-
-  // build vendor and product 4-char hex strings
-  llvm::SmallString<16> vendorStr, productStr;
-  llvm::raw_svector_ostream vendorOs{vendorStr}, productOs{productStr};
-  vendorOs << llvm::format_hex_no_prefix(vendor, 4);
-  productOs << llvm::format_hex_no_prefix(product, 4);
-
-  // scan file
-  llvm::SmallString<128> lineBuf;
-  bool foundVendor = false;
-  for (;;) {
-    bool error = false;
-    auto line = ReadLine(is, lineBuf, 4096, &error);
-    if (error) break;
-
-    if (line.empty()) continue;
-
-    // look for vendor at start of line
-    if (line.startswith(vendorStr)) {
-      foundVendor = true;
-      os << line.substr(5).trim() << ' ';
-      continue;
-    }
+// Process-wide index of usb.ids, built on first use.  The file is mapped
+// once and names refer into the mapping, so lookups don't touch the disk.
+class UsbIdDatabase {
+ public:
+  static UsbIdDatabase& GetInstance() {
+    ATOMIC_STATIC(UsbIdDatabase, instance);
+    return instance;
+  }
 
-    if (foundVendor) {
-      // next vendor, but didn't match product?
-      if (line[0] != '\t') {
-        os << "Unknown";
-        return os.str();
-      }
+  // Returns "vendor product" (or "vendor Unknown" if only the vendor is
+  // listed), or an empty string if the vendor is not listed.
+  llvm::StringRef Lookup(int vendor, int product,
+                         llvm::SmallVectorImpl<char>& buf) const;
+
+ private:
+  UsbIdDatabase();
+
+  struct Vendor {
+    int id;
+    llvm::StringRef name;
+    std::size_t productBegin;  // range in m_products
+    std::size_t productEnd;
+  };
+  struct Product {
+    int id;
+    llvm::StringRef name;
+  };
+
+  std::vector<Vendor> m_vendors;    // sorted by id
+  std::vector<Product> m_products;  // sorted by id within each vendor
+
+  ATOMIC_STATIC_DECL(UsbIdDatabase)
+};
+
+ATOMIC_STATIC_INIT(UsbIdDatabase)
+
+// Parses "xxxx  name" (4 hex digit id, then the name)
+static bool ParseIdLine(llvm::StringRef line, int* id, llvm::StringRef* name) {
+  if (line.size() < 6 || line[4] != ' ') return false;
+  unsigned value;
+  if (line.substr(0, 4).getAsInteger(16, value)) return false;
+  *id = value;
+  *name = line.substr(5).trim();
+  return true;
+}
 
-      // look for product
-      if (line.substr(1).startswith(productStr)) {
-        os << line.substr(6).trim();
-        return os.str();
-      }
+UsbIdDatabase::UsbIdDatabase() {
+  int fd = open(kUsbIdsPath, O_RDONLY);
+  if (fd < 0) return;
+  struct stat st;
+  void* data = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0)
+    data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) return;
+
+  // The mapping is never unmapped as the index refers into it
+  llvm::StringRef rest{static_cast<const char*>(data),
+                       static_cast<std::size_t>(st.st_size)};
+  while (!rest.empty()) {
+    llvm::StringRef line;
+    std::tie(line, rest) = rest.split('\n');
+    line = line.rtrim("\r");
+    if (line.empty() || line[0] == '#') continue;
+
+    int id;
+    llvm::StringRef name;
+    if (line[0] != '\t') {
+      // The vendor list is followed by other sections (device classes,
+      // etc.) that are not needed
+      if (!ParseIdLine(line, &id, &name)) break;
+      m_vendors.push_back(
+          Vendor{id, name, m_products.size(), m_products.size()});
+    } else if (line.size() > 1 && line[1] != '\t' && !m_vendors.empty()) {
+      // Product of the last vendor (interfaces are indented further)
+      if (!ParseIdLine(line.substr(1), &id, &name)) continue;
+      m_products.push_back(Product{id, name});
+      m_vendors.back().productEnd = m_products.size();
     }
   }
 
-  return llvm::StringRef{};
+  // The file is sorted, but don't depend on it
+  auto productLess = [](const Product& a, const Product& b) {
+    return a.id < b.id;
+  };
+  for (const auto& v : m_vendors) {
+    std::sort(m_products.begin() + v.productBegin,
+              m_products.begin() + v.productEnd, productLess);
+  }
+  std::stable_sort(
+      m_vendors.begin(), m_vendors.end(),
+      [](const Vendor& a, const Vendor& b) { return a.id < b.id; });
+}
+
+llvm::StringRef UsbIdDatabase::Lookup(int vendor, int product,
+                                      llvm::SmallVectorImpl<char>& buf) const {
+  auto v = std::lower_bound(
+      m_vendors.begin(), m_vendors.end(), vendor,
+      [](const Vendor& a, int id) { return a.id < id; });
+  if (v == m_vendors.end() || v->id != vendor) return llvm::StringRef{};
+
+  llvm::raw_svector_ostream os{buf};
+  os << v->name << ' ';
+  auto begin = m_products.begin() + v->productBegin;
+  auto end = m_products.begin() + v->productEnd;
+  auto p = std::lower_bound(begin, end, product,
+                            [](const Product& a, int id) { return a.id < id; });
+  if (p != end && p->id == product)
+    os << p->name;
+  else
+    os << "Unknown";
+  return os.str();
 }
 
 llvm::StringRef GetUsbNameFromId(int vendor, int product,
                                  llvm::SmallVectorImpl<char>& buf) {
   // try reading usb.ids
-  llvm::StringRef rv = GetUsbNameFromFile(vendor, product, buf);
+  llvm::StringRef rv =
+      UsbIdDatabase::GetInstance().Lookup(vendor, product, buf);
   if (!rv.empty()) return rv;
 
   // Fall back to internal database
@@ -37,6 +37,12 @@ void CS_SetProperty(CS_Property property, int value, CS_Status* status) {
   return cs::SetProperty(property, value, status);
 }
 
+void CS_SetProperties(const CS_Property* properties, const int* values,
+                      int count, CS_Status* status) {
+  return cs::SetProperties(llvm::makeArrayRef(properties, count),
+                           llvm::makeArrayRef(values, count), status);
+}
+
 int CS_GetPropertyMin(CS_Property property, CS_Status* status) {
   return cs::GetPropertyMin(property, status);
 }
@@ -97,6 +103,53 @@ uint64_t CS_GetSourceLastFrameTime(CS_Source source, CS_Status* status) {
   return cs::GetSourceLastFrameTime(source, status);
 }
 
+uint64_t CS_GetSourceLastFrameSequence(CS_Source source, CS_Status* status) {
+  return cs::GetSourceLastFrameSequence(source, status);
+}
+
+void CS_SetSourceFrameRingSize(CS_Source source, int size, CS_Status* status) {
+  return cs::SetSourceFrameRingSize(source, size, status);
+}
+
+int CS_GetSourceFrameRingSize(CS_Source source, CS_Status* status) {
+  return cs::GetSourceFrameRingSize(source, status);
+}
+
+void CS_SetSourceDeferLowPriority(CS_Source source, CS_Bool defer,
+                                  CS_Status* status) {
+  return cs::SetSourceDeferLowPriority(source, defer, status);
+}
+
+CS_Bool CS_GetSourceDeferLowPriority(CS_Source source, CS_Status* status) {
+  return cs::GetSourceDeferLowPriority(source, status);
+}
+
+void CS_SetSourceMaxFPS(CS_Source source, double fps, CS_Status* status) {
+  return cs::SetSourceMaxFPS(source, fps, status);
+}
+
+double CS_GetSourceMaxFPS(CS_Source source, CS_Status* status) {
+  return cs::GetSourceMaxFPS(source, status);
+}
+
+void CS_SetSourceDecimation(CS_Source source, int decimation,
+                            CS_Status* status) {
+  return cs::SetSourceDecimation(source, decimation, status);
+}
+
+int CS_GetSourceDecimation(CS_Source source, CS_Status* status) {
+  return cs::GetSourceDecimation(source, status);
+}
+
+void CS_SetSourceAutoVideoMode(CS_Source source, CS_Bool enabled,
+                               CS_Status* status) {
+  return cs::SetSourceAutoVideoMode(source, enabled, status);
+}
+
+CS_Bool CS_GetSourceAutoVideoMode(CS_Source source, CS_Status* status) {
+  return cs::GetSourceAutoVideoMode(source, status);
+}
+
 CS_Bool CS_IsSourceConnected(CS_Source source, CS_Status* status) {
   return cs::IsSourceConnected(source, status);
 }
@@ -247,6 +300,18 @@ CS_Source CS_GetSinkSource(CS_Sink sink, CS_Status* status) {
   return cs::GetSinkSource(sink, status);
 }
 
+int CS_GetSinkEventFd(CS_Sink sink, CS_Status* status) {
+  return cs::GetSinkEventFd(sink, status);
+}
+
+void CS_SetSinkPriority(CS_Sink sink, int priority, CS_Status* status) {
+  return cs::SetSinkPriority(sink, priority, status);
+}
+
+int CS_GetSinkPriority(CS_Sink sink, CS_Status* status) {
+  return cs::GetSinkPriority(sink, status);
+}
+
 CS_Property CS_GetSinkSourceProperty(CS_Sink sink, const char* name,
                                      CS_Status* status) {
   return cs::GetSinkSourceProperty(sink, name, status);
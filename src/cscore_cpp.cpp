@@ -22,6 +22,7 @@
 #include "Notifier.h"
 #include "SinkImpl.h"
 #include "SourceImpl.h"
+#include "UsbCameraRegistry.h"
 
 using namespace cs;
 
@@ -87,6 +88,31 @@ void SetProperty(CS_Property property, int value, CS_Status* status) {
   source->SetProperty(propertyIndex, value, status);
 }
 
+void SetProperties(llvm::ArrayRef<CS_Property> properties,
+                   llvm::ArrayRef<int> values, CS_Status* status) {
+  if (properties.size() != values.size()) {
+    *status = CS_INVALID_PARAMETER;
+    return;
+  }
+  if (properties.empty()) return;
+
+  // All properties must belong to the same source
+  std::shared_ptr<SourceImpl> source;
+  llvm::SmallVector<int, 16> indices;
+  for (auto property : properties) {
+    int propertyIndex;
+    auto propSource = GetPropertySource(property, &propertyIndex, status);
+    if (!propSource) return;
+    if (source && propSource != source) {
+      *status = CS_INVALID_PARAMETER;
+      return;
+    }
+    source = propSource;
+    indices.push_back(propertyIndex);
+  }
+  source->SetProperties(indices, values, status);
+}
+
 int GetPropertyMin(CS_Property property, CS_Status* status) {
   int propertyIndex;
   auto source = GetPropertySource(property, &propertyIndex, status);
@@ -211,6 +237,107 @@ uint64_t GetSourceLastFrameTime(CS_Source source, CS_Status* status) {
   return data->source->GetCurFrameTime();
 }
 
+uint64_t GetSourceLastFrameSequence(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return data->source->GetCurFrameSequence();
+}
+
+void SetSourceFrameRingSize(CS_Source source, int size, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  data->source->SetFrameRingSize(size);
+}
+
+int GetSourceFrameRingSize(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return data->source->GetFrameRingSize();
+}
+
+void SetSourceDeferLowPriority(CS_Source source, bool defer,
+                               CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  data->source->SetDeferLowPriority(defer);
+}
+
+bool GetSourceDeferLowPriority(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return false;
+  }
+  return data->source->GetDeferLowPriority();
+}
+
+void SetSourceMaxFPS(CS_Source source, double fps, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  data->source->SetMaxFPS(fps);
+}
+
+double GetSourceMaxFPS(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return data->source->GetMaxFPS();
+}
+
+void SetSourceDecimation(CS_Source source, int decimation, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  data->source->SetDecimation(decimation);
+}
+
+int GetSourceDecimation(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return data->source->GetDecimation();
+}
+
+void SetSourceAutoVideoMode(CS_Source source, bool enabled,
+                            CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  data->source->SetAutoVideoMode(enabled);
+}
+
+bool GetSourceAutoVideoMode(CS_Source source, CS_Status* status) {
+  auto data = Sources::GetInstance().Get(source);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return false;
+  }
+  return data->source->GetAutoVideoMode();
+}
+
 bool IsSourceConnected(CS_Source source, CS_Status* status) {
   auto data = Sources::GetInstance().Get(source);
   if (!data) {
@@ -508,6 +635,33 @@ CS_Source GetSinkSource(CS_Sink sink, CS_Status* status) {
   return data->sourceHandle.load();
 }
 
+int GetSinkEventFd(CS_Sink sink, CS_Status* status) {
+  auto data = Sinks::GetInstance().Get(sink);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return -1;
+  }
+  return data->sink->GetEventFd();
+}
+
+void SetSinkPriority(CS_Sink sink, int priority, CS_Status* status) {
+  auto data = Sinks::GetInstance().Get(sink);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return;
+  }
+  data->sink->SetPriority(priority);
+}
+
+int GetSinkPriority(CS_Sink sink, CS_Status* status) {
+  auto data = Sinks::GetInstance().Get(sink);
+  if (!data) {
+    *status = CS_INVALID_HANDLE;
+    return 0;
+  }
+  return data->sink->GetPriority();
+}
+
 CS_Property GetSinkSourceProperty(CS_Sink sink, llvm::StringRef name,
                                   CS_Status* status) {
   auto data = Sinks::GetInstance().Get(sink);
@@ -566,6 +720,11 @@ CS_Listener AddListener(std::function<void(const RawEvent& event)> callback,
     if (immediateNotify)
       Notifier::GetInstance().NotifyNetworkInterfacesChanged();
   }
+  if ((eventMask & CS_USB_CAMERAS_CHANGED) != 0) {
+    // start USB camera registry (hotplug watcher)
+    UsbCameraRegistry::GetInstance().Start();
+    if (immediateNotify) Notifier::GetInstance().NotifyUsbCamerasChanged();
+  }
   if (immediateNotify) {
     // TODO
   }
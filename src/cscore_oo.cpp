@@ -7,6 +7,8 @@
 
 #include "cscore_oo.h"
 
+#include <algorithm>
+
 using namespace cs;
 
 std::vector<VideoProperty> VideoSource::EnumerateProperties() const {
@@ -21,6 +23,14 @@ std::vector<VideoProperty> VideoSource::EnumerateProperties() const {
   return properties;
 }
 
+void VideoSource::SetProperties(llvm::ArrayRef<VideoProperty> properties,
+                                llvm::ArrayRef<int> values) {
+  llvm::SmallVector<CS_Property, 16> handles;
+  for (const auto& property : properties) handles.push_back(property.m_handle);
+  m_status = 0;
+  ::cs::SetProperties(handles, values, &m_status);
+}
+
 std::vector<VideoSink> VideoSource::EnumerateSinks() {
   llvm::SmallVector<CS_Sink, 16> handles_buf;
   CS_Status status = 0;
@@ -56,3 +66,33 @@ std::vector<VideoSink> VideoSink::EnumerateSinks() {
     sinks.emplace_back(VideoSink{handle});
   return sinks;
 }
+
+uint64_t CvSink::GrabFramesSync(llvm::ArrayRef<CvSink> sinks,
+                                llvm::MutableArrayRef<cv::Mat> images,
+                                double tolerance, double timeout,
+                                uint64_t* skew, uint64_t* dropped,
+                                CS_Status* status) {
+  llvm::SmallVector<CS_Sink, 4> handles;
+  handles.reserve(sinks.size());
+  for (const auto& sink : sinks) handles.push_back(sink.GetHandle());
+  return GrabSinkFramesSync(handles, images, tolerance, timeout, skew, dropped,
+                            status);
+}
+
+std::vector<int> CvSink::WaitForAnyFrame(llvm::ArrayRef<CvSink> sinks,
+                                         double timeout) {
+  llvm::SmallVector<CS_Sink, 8> handles;
+  handles.reserve(sinks.size());
+  for (const auto& sink : sinks) handles.push_back(sink.GetHandle());
+
+  llvm::SmallVector<CS_Sink, 8> ready_buf;
+  CS_Status status = 0;
+  auto ready = WaitForAnySinkFrame(handles, timeout, ready_buf, &status);
+
+  std::vector<int> indices;
+  for (std::size_t i = 0; i < handles.size(); ++i) {
+    if (std::find(ready.begin(), ready.end(), handles[i]) != ready.end())
+      indices.push_back(i);
+  }
+  return indices;
+}
@@ -0,0 +1,98 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <opencv2/core/core.hpp>
+
+#include "cscore_cpp.h"
+
+namespace cs {
+
+class SinkPriorityTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    CS_Status status = 0;
+    m_source = CreateCvSource("source", VideoMode{VideoMode::kBGR, 4, 4, 30},
+                              &status);
+    ASSERT_EQ(0, status);
+    SetSourceDeferLowPriority(m_source, true, &status);
+    m_high = CreateCvSink("high", &status);
+    m_low = CreateCvSink("low", &status);
+    ASSERT_EQ(0, status);
+    SetSinkPriority(m_high, 10, &status);
+    SetSinkSource(m_high, m_source, &status);
+    SetSinkSource(m_low, m_source, &status);
+    ASSERT_EQ(0, status);
+  }
+
+  void TearDown() override {
+    CS_Status status = 0;
+    ReleaseSink(m_high, &status);
+    ReleaseSink(m_low, &status);
+    ReleaseSource(m_source, &status);
+  }
+
+  void PutFrame() {
+    cv::Mat image{4, 4, CV_8UC3, cv::Scalar{0, 0, 0}};
+    CS_Status status = 0;
+    PutSourceFrame(m_source, image, &status);
+    ASSERT_EQ(0, status);
+  }
+
+  CS_Source m_source = 0;
+  CS_Sink m_high = 0;
+  CS_Sink m_low = 0;
+};
+
+// A high priority sink whose predicate a frame doesn't satisfy must not hold
+// off lower priority sinks for longer than the deferral cap.
+TEST_F(SinkPriorityTest, EveryNthDoesNotStarveLowPriority) {
+  CS_Status status = 0;
+  SetSinkDeliveryMode(m_high, CS_SINK_DELIVER_EVERY_NTH, 3, &status);
+  ASSERT_EQ(0, status);
+
+  // The high priority sink waits longer than the low priority one, so only
+  // the deferral cap can release the low priority sink early
+  uint64_t highTime = 0;
+  std::thread high{[&] {
+    cv::Mat image;
+    CS_Status highStatus = 0;
+    highTime = GrabSinkFrameTimeout(m_high, image, 5.0, &highStatus);
+  }};
+
+  uint64_t lowTime = 0;
+  std::chrono::steady_clock::time_point lowDone;
+  std::thread low{[&] {
+    cv::Mat image;
+    CS_Status lowStatus = 0;
+    lowTime = GrabSinkFrameTimeout(m_low, image, 2.0, &lowStatus);
+    lowDone = std::chrono::steady_clock::now();
+  }};
+
+  // Let both sinks start waiting, then put the first frame, which the
+  // every-3rd sink doesn't take
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  auto put = std::chrono::steady_clock::now();
+  PutFrame();
+  low.join();
+
+  // Frames 2 and 3 complete the every-3rd sink's wait
+  PutFrame();
+  PutFrame();
+  high.join();
+
+  EXPECT_NE(0u, lowTime);
+  EXPECT_LT(lowDone - put, std::chrono::milliseconds(500));
+  EXPECT_NE(0u, highTime);
+}
+
+}  // namespace cs
@@ -0,0 +1,205 @@
+/*----------------------------------------------------------------------------*/
+/* Copyright (c) FIRST 2016. All Rights Reserved.                             */
+/* Open Source Software - may be modified and shared by FRC teams. The code   */
+/* must be accompanied by the FIRST BSD license file in the root directory of */
+/* the project.                                                               */
+/*----------------------------------------------------------------------------*/
+
+#include "gtest/gtest.h"
+
+#ifdef __linux__
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#endif
+
+#include "UsbBandwidth.h"
+
+namespace cs {
+
+class UsbBandwidthTest : public ::testing::Test {
+ protected:
+  // A camera on a high speed bus wanting mode, with MJPEG fallbacks
+  static UsbBandwidthCamera HighSpeed(const std::string& bus,
+                                      const VideoMode& mode) {
+    UsbBandwidthCamera camera;
+    camera.bus = bus;
+    camera.busCapacity = GetUsbBusCapacity(480);
+    camera.deviceCapacity = GetUsbDeviceCapacity(480);
+    std::vector<VideoMode> supported{
+        VideoMode{VideoMode::kYUYV, mode.width, mode.height, 30},
+        VideoMode{VideoMode::kMJPEG, mode.width, mode.height, 30},
+        VideoMode{VideoMode::kMJPEG, mode.width, mode.height, 15}};
+    camera.candidates = GetUsbModeCandidates(mode, supported);
+    return camera;
+  }
+
+  VideoMode m_yuyv{VideoMode::kYUYV, 640, 480, 30};
+};
+
+TEST_F(UsbBandwidthTest, Estimate) {
+  EXPECT_EQ(640u * 480 * 30 * 2, EstimateUsbBandwidth(m_yuyv));
+  EXPECT_LT(EstimateUsbBandwidth(VideoMode{VideoMode::kMJPEG, 640, 480, 30}),
+            EstimateUsbBandwidth(m_yuyv));
+  EXPECT_EQ(0u, EstimateUsbBandwidth(VideoMode{}));
+}
+
+TEST_F(UsbBandwidthTest, Candidates) {
+  auto candidates = HighSpeed("1", m_yuyv).candidates;
+  ASSERT_EQ(3u, candidates.size());
+  EXPECT_EQ(VideoMode::kYUYV, candidates[0].pixelFormat);
+  EXPECT_EQ(VideoMode::kMJPEG, candidates[1].pixelFormat);
+  EXPECT_EQ(30, candidates[1].fps);
+  EXPECT_EQ(15, candidates[2].fps);
+}
+
+TEST_F(UsbBandwidthTest, Fits) {
+  std::vector<UsbBandwidthCamera> cameras{HighSpeed("1", m_yuyv),
+                                          HighSpeed("1", m_yuyv)};
+  std::vector<std::size_t> choices;
+  EXPECT_TRUE(PlanUsbBandwidth(cameras, &choices));
+  EXPECT_EQ((std::vector<std::size_t>{0, 0}), choices);
+}
+
+TEST_F(UsbBandwidthTest, SharedBusFallsBackToMjpeg) {
+  std::vector<UsbBandwidthCamera> cameras{HighSpeed("1", m_yuyv),
+                                          HighSpeed("1", m_yuyv),
+                                          HighSpeed("1", m_yuyv)};
+  std::vector<std::size_t> choices;
+  EXPECT_TRUE(PlanUsbBandwidth(cameras, &choices));
+  EXPECT_EQ((std::vector<std::size_t>{1, 0, 0}), choices);
+}
+
+TEST_F(UsbBandwidthTest, SeparateBuses) {
+  std::vector<UsbBandwidthCamera> cameras{
+      HighSpeed("1", m_yuyv), HighSpeed("1", m_yuyv), HighSpeed("2", m_yuyv),
+      HighSpeed("2", m_yuyv)};
+  std::vector<std::size_t> choices;
+  EXPECT_TRUE(PlanUsbBandwidth(cameras, &choices));
+  EXPECT_EQ((std::vector<std::size_t>{0, 0, 0, 0}), choices);
+}
+
+TEST_F(UsbBandwidthTest, DeviceLink) {
+  // 1280x720 YUYV at 30 fps exceeds a single high speed endpoint
+  std::vector<UsbBandwidthCamera> cameras{
+      HighSpeed("1", VideoMode{VideoMode::kYUYV, 1280, 720, 30})};
+  std::vector<std::size_t> choices;
+  EXPECT_TRUE(PlanUsbBandwidth(cameras, &choices));
+  EXPECT_EQ(1u, choices[0]);
+}
+
+TEST_F(UsbBandwidthTest, Oversubscribed) {
+  std::vector<UsbBandwidthCamera> cameras;
+  for (int i = 0; i < 4; ++i) {
+    auto camera = HighSpeed("1", m_yuyv);
+    camera.candidates.resize(1);  // no fallbacks
+    cameras.push_back(camera);
+  }
+  std::vector<std::size_t> choices;
+  EXPECT_FALSE(PlanUsbBandwidth(cameras, &choices));
+}
+
+TEST_F(UsbBandwidthTest, UnknownBus) {
+  std::vector<UsbBandwidthCamera> cameras;
+  for (int i = 0; i < 4; ++i) {
+    UsbBandwidthCamera camera;
+    camera.candidates.push_back(m_yuyv);
+    cameras.push_back(camera);
+  }
+  std::vector<std::size_t> choices;
+  EXPECT_TRUE(PlanUsbBandwidth(cameras, &choices));
+}
+
+#ifdef __linux__
+
+// Builds a minimal sysfs tree in a temporary directory
+class UsbTopologyTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char tmpl[] = "/tmp/cscore-sysfs-XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(tmpl));
+    m_root = tmpl;
+  }
+
+  void TearDown() override {
+    std::string cmd = "rm -rf '" + m_root + "'";
+    EXPECT_EQ(0, system(cmd.c_str()));
+  }
+
+  void MakeDir(const std::string& path) {
+    std::string cmd = "mkdir -p '" + m_root + "/" + path + "'";
+    ASSERT_EQ(0, system(cmd.c_str()));
+  }
+
+  void WriteFile(const std::string& path, const std::string& contents) {
+    std::ofstream os{m_root + "/" + path};
+    os << contents << '\n';
+  }
+
+  // Links class/video4linux/<video>/device to target
+  int MakeLink(const std::string& video, const std::string& target) {
+    MakeDir("class/video4linux/" + video);
+    std::string link = m_root + "/class/video4linux/" + video + "/device";
+    return symlink((m_root + "/" + target).c_str(), link.c_str());
+  }
+
+  // Adds video as interface 1.0 of a USB device (e.g. "1-2") on a bus
+  void AddCamera(const std::string& video, const std::string& device,
+                 const std::string& busnum, const std::string& speed) {
+    std::string devPath = "devices/usb" + busnum + "/" + device;
+    MakeDir(devPath + "/" + device + ":1.0");
+    WriteFile(devPath + "/busnum", busnum);
+    WriteFile(devPath + "/speed", speed);
+    ASSERT_EQ(0, MakeLink(video, devPath + "/" + device + ":1.0"));
+  }
+
+  std::string m_root;
+};
+
+TEST_F(UsbTopologyTest, HighSpeedDevice) {
+  MakeDir("bus/usb/devices/usb1");
+  WriteFile("bus/usb/devices/usb1/speed", "480");
+  AddCamera("video0", "1-2", "1", "480");
+
+  UsbBandwidthCamera camera;
+  ASSERT_TRUE(ReadUsbTopology("/dev/video0", &camera, m_root));
+  EXPECT_EQ("1", camera.bus);
+  EXPECT_EQ(GetUsbBusCapacity(480), camera.busCapacity);
+  EXPECT_EQ(GetUsbDeviceCapacity(480), camera.deviceCapacity);
+}
+
+TEST_F(UsbTopologyTest, FullSpeedDeviceOnSuperSpeedBus) {
+  MakeDir("bus/usb/devices/usb2");
+  WriteFile("bus/usb/devices/usb2/speed", "5000");
+  AddCamera("video1", "2-1", "2", "12");
+
+  UsbBandwidthCamera camera;
+  ASSERT_TRUE(ReadUsbTopology("/dev/video1", &camera, m_root));
+  EXPECT_EQ("2", camera.bus);
+  EXPECT_EQ(GetUsbBusCapacity(5000), camera.busCapacity);
+  EXPECT_EQ(GetUsbDeviceCapacity(12), camera.deviceCapacity);
+}
+
+TEST_F(UsbTopologyTest, MissingRootHubUsesDeviceSpeed) {
+  AddCamera("video2", "3-1", "3", "1.5");
+
+  UsbBandwidthCamera camera;
+  ASSERT_TRUE(ReadUsbTopology("/dev/video2", &camera, m_root));
+  EXPECT_EQ("3", camera.bus);
+  EXPECT_EQ(GetUsbBusCapacity(1), camera.busCapacity);
+}
+
+TEST_F(UsbTopologyTest, NotUsb) {
+  MakeDir("devices/platform/vivid.0");
+  MakeLink("video3", "devices/platform/vivid.0");
+
+  UsbBandwidthCamera camera;
+  EXPECT_FALSE(ReadUsbTopology("/dev/video3", &camera, m_root));
+  EXPECT_FALSE(ReadUsbTopology("/dev/video9", &camera, m_root));
+}
+
+#endif  // __linux__
+
+}  // namespace cs